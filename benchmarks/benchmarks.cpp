@@ -0,0 +1,487 @@
+// Microbenchmarks for lookups, iteration and building, with standard containers as baselines.
+//
+// Usage: benchmarks [--max-size N] [--filter SUBSTRING] [--output FILE]
+//
+// The containers have 1K, 10K, ... entries up to --max-size (default: 1M, up to 100M). The
+// input data are generated with a fixed seed, such that the runs are reproducible. The
+// results are written as JSON to stdout or to FILE, and the progress to stderr.
+
+#include <pid/builder.h>
+#include <pid/pid-build-datastructures.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <memory>
+#include <random>
+#include <span>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+    struct options
+    {
+        std::size_t max_size{1'000'000};
+        std::string filter;
+        std::string output;
+    };
+
+    struct result
+    {
+        std::string name;
+        std::size_t size;
+        std::size_t iterations;
+        double ns_per_operation;
+        double bytes_per_second;
+    };
+
+    // Keeps the compiler from optimizing away the computation of 'value'
+    template <typename T>
+    void do_not_optimize(const T & value)
+    {
+        asm volatile("" : : "r,m"(value) : "memory");
+    }
+
+    class benchmark_runner
+    {
+    public:
+        explicit benchmark_runner(options o) : o{std::move(o)} {}
+
+        std::vector<result> results;
+
+        [[nodiscard]] std::vector<std::size_t> sizes() const
+        {
+            std::vector<std::size_t> result;
+            for (std::size_t size{1000}; size <= o.max_size; size *= 10) {
+                result.push_back(size);
+            }
+            return result;
+        }
+
+        [[nodiscard]] bool enabled(const std::string & name) const
+        {
+            return name.find(o.filter) != std::string::npos;
+        }
+
+        // Runs 'run' repeatedly for at least 'minimum_time' and records the fastest of
+        // 'repetitions' runs. Each call of 'run' performs 'operations' operations and
+        // processes 'bytes' bytes.
+        template <typename Run>
+        void measure(
+            const std::string & name, std::size_t size, std::size_t operations,
+            std::size_t bytes, Run run)
+        {
+            using clock = std::chrono::steady_clock;
+            constexpr std::size_t repetitions{5};
+            constexpr auto minimum_time{std::chrono::milliseconds{100}};
+
+            std::cerr << name << "/" << size << std::flush;
+
+            run();
+
+            double best{std::numeric_limits<double>::max()};
+            std::size_t iterations{0};
+            for (std::size_t repetition{0}; repetition < repetitions; ++repetition) {
+                std::size_t count{0};
+                const auto start{clock::now()};
+                auto end{start};
+                do {
+                    run();
+                    ++count;
+                    end = clock::now();
+                } while (end - start < minimum_time);
+
+                const double seconds{std::chrono::duration<double>(end - start).count()};
+                if (seconds / static_cast<double>(count) < best) {
+                    best = seconds / static_cast<double>(count);
+                    iterations = count;
+                }
+            }
+
+            results.push_back({
+                name, size, iterations, best * 1e9 / static_cast<double>(operations),
+                static_cast<double>(bytes) / best});
+            std::cerr << ": " << results.back().ns_per_operation << " ns" << std::endl;
+        }
+
+        void write_json(std::ostream & out) const
+        {
+            out << "{\n  \"context\": {\"threads\": " << std::thread::hardware_concurrency()
+                << ", \"max_size\": " << o.max_size << "},\n  \"benchmarks\": [";
+
+            for (std::size_t i{0}; i < results.size(); ++i) {
+                const auto & r{results[i]};
+                out << (i == 0 ? "\n" : ",\n") << "    {\"name\": \"" << r.name
+                    << "\", \"size\": " << r.size << ", \"iterations\": " << r.iterations
+                    << ", \"ns_per_operation\": " << r.ns_per_operation
+                    << ", \"bytes_per_second\": " << r.bytes_per_second << "}";
+            }
+
+            out << "\n  ]\n}\n";
+        }
+
+    private:
+        options o;
+    };
+
+    constexpr std::size_t lookup_count{1 << 16};
+
+    std::mt19937_64 random_engine()
+    {
+        return std::mt19937_64{42};
+    }
+
+    std::vector<std::int64_t> random_keys(std::size_t size)
+    {
+        auto engine{random_engine()};
+        std::vector<std::int64_t> result(size);
+        for (auto & key : result) {
+            key = static_cast<std::int64_t>(engine() >> 1);
+        }
+
+        std::sort(result.begin(), result.end());
+        result.erase(std::unique(result.begin(), result.end()), result.end());
+        return result;
+    }
+
+    // A common prefix makes the comparisons more expensive
+    constexpr std::string_view common_prefix{"some/common/prefix/"};
+
+    std::vector<std::string> random_strings(std::size_t size, std::string_view prefix)
+    {
+        const auto numbers{random_keys(size)};
+        std::vector<std::string> result;
+        result.reserve(numbers.size());
+        for (const auto number : numbers) {
+            result.push_back(std::string{prefix} + std::to_string(number));
+        }
+
+        std::sort(result.begin(), result.end());
+        return result;
+    }
+
+    // Keys which are looked up, in random order
+    template <typename T>
+    std::vector<T> lookup_keys(const std::vector<T> & keys)
+    {
+        auto engine{random_engine()};
+        std::uniform_int_distribution<std::size_t> index{0, keys.size() - 1};
+
+        std::vector<T> result;
+        result.reserve(lookup_count);
+        for (std::size_t i{0}; i < lookup_count; ++i) {
+            result.push_back(keys[index(engine)]);
+        }
+        return result;
+    }
+
+    template <typename PidKey, typename Key>
+    void benchmark_map_find(
+        benchmark_runner & runner, const std::string & name, const std::vector<Key> & keys)
+    {
+        const auto lookups{lookup_keys(keys)};
+        const std::size_t size{keys.size()};
+
+        if (runner.enabled(name + "/pid::map::find")) {
+            using MapType = pid::map<PidKey, std::int64_t>;
+
+            pid::builder b;
+            {
+                auto root{b.add<MapType>()};
+                auto map{b.add_map<PidKey, std::int64_t, std::uint32_t>(size)};
+                *root = map.items;
+                for (std::size_t i{0}; i < size; ++i) {
+                    if constexpr (std::is_same_v<PidKey, pid::prefix_string>) {
+                        *map.add_key(b.add_prefix_string(keys[i])) =
+                            static_cast<std::int64_t>(i);
+                    } else if constexpr (std::is_same_v<Key, std::string>) {
+                        *map.add_key(b.add_string(keys[i])) = static_cast<std::int64_t>(i);
+                    } else {
+                        *map.add_key(keys[i]) = static_cast<std::int64_t>(i);
+                    }
+                }
+            }
+            const auto & map{*reinterpret_cast<const MapType *>(b.data.data())};
+
+            runner.measure(name + "/pid::map::find", size, lookup_count, 0, [&] {
+                for (const auto & key : lookups) {
+                    do_not_optimize(map.find(key)->second);
+                }
+            });
+
+            std::vector<typename MapType::const_iterator> results(lookups.size());
+            runner.measure(name + "/pid::map::find_batch", size, lookup_count, 0, [&] {
+                map.find_batch(std::span<const Key>{lookups}, std::span{results});
+                do_not_optimize(results.back()->second);
+            });
+        }
+
+        if constexpr (std::is_integral_v<Key>) {
+            if (runner.enabled(name + "/pid::s_tree_map::find")) {
+                using MapType = pid::s_tree_map<Key, std::int64_t>;
+
+                pid::builder b;
+                {
+                    auto root{b.add<MapType>()};
+                    auto map{b.add_s_tree_map<Key, std::int64_t, std::uint32_t>(
+                        static_cast<std::uint32_t>(size))};
+                    *root = map.offset();
+                    for (std::size_t i{0}; i < size; ++i) {
+                        *map.add_key(keys[i]) = static_cast<std::int64_t>(i);
+                    }
+                }
+                const auto & map{*reinterpret_cast<const MapType *>(b.data.data())};
+
+                runner.measure(name + "/pid::s_tree_map::find", size, lookup_count, 0, [&] {
+                    for (const auto & key : lookups) {
+                        do_not_optimize(map.find(key)->second);
+                    }
+                });
+            }
+        }
+
+        if (runner.enabled(name + "/std::map::find")) {
+            std::map<Key, std::int64_t> map;
+            for (std::size_t i{0}; i < size; ++i) {
+                map.emplace(keys[i], static_cast<std::int64_t>(i));
+            }
+
+            runner.measure(name + "/std::map::find", size, lookup_count, 0, [&] {
+                for (const auto & key : lookups) {
+                    do_not_optimize(map.find(key)->second);
+                }
+            });
+        }
+
+        if (runner.enabled(name + "/std::unordered_map::find")) {
+            std::unordered_map<Key, std::int64_t> map;
+            map.reserve(size);
+            for (std::size_t i{0}; i < size; ++i) {
+                map.emplace(keys[i], static_cast<std::int64_t>(i));
+            }
+
+            runner.measure(name + "/std::unordered_map::find", size, lookup_count, 0, [&] {
+                for (const auto & key : lookups) {
+                    do_not_optimize(map.find(key)->second);
+                }
+            });
+        }
+
+        if (runner.enabled(name + "/std::vector::lower_bound")) {
+            runner.measure(name + "/std::vector::lower_bound", size, lookup_count, 0, [&] {
+                for (const auto & key : lookups) {
+                    do_not_optimize(*std::lower_bound(keys.begin(), keys.end(), key));
+                }
+            });
+        }
+    }
+
+    void benchmark_vector_iteration(benchmark_runner & runner, std::size_t size)
+    {
+        const std::size_t bytes{size * sizeof(std::int64_t)};
+        const auto values{random_keys(size)};
+
+        if (runner.enabled("vector_iteration/pid::vector")) {
+            pid::builder b;
+            {
+                auto root{b.add<pid::vector<std::int64_t>>()};
+                auto items{b.add_vector<std::int64_t, std::uint32_t>(values.size())};
+                *root = items;
+                for (std::size_t i{0}; i < values.size(); ++i) {
+                    (*items)[i] = values[i];
+                }
+            }
+            const auto & v{*reinterpret_cast<const pid::vector<std::int64_t> *>(b.data.data())};
+
+            runner.measure("vector_iteration/pid::vector", size, size, bytes, [&] {
+                std::int64_t sum{0};
+                for (const auto value : v) {
+                    sum += value;
+                }
+                do_not_optimize(sum);
+            });
+        }
+
+        if (runner.enabled("vector_iteration/std::vector")) {
+            runner.measure("vector_iteration/std::vector", size, size, bytes, [&] {
+                std::int64_t sum{0};
+                for (const auto value : values) {
+                    sum += value;
+                }
+                do_not_optimize(sum);
+            });
+        }
+    }
+
+    void benchmark_string_compare(benchmark_runner & runner)
+    {
+        const auto strings{random_strings(1000, common_prefix)};
+        const auto others{lookup_keys(strings)};
+
+        if (runner.enabled("string_compare/pid::string")) {
+            pid::builder b;
+            {
+                auto items{b.add_vector<pid::string, std::uint32_t>(strings.size())};
+                for (std::size_t i{0}; i < strings.size(); ++i) {
+                    (*items)[i] = b.add_string(strings[i]);
+                }
+            }
+            const auto & v{*reinterpret_cast<const pid::detail::generic_vector_data<
+                pid::string, std::uint32_t> *>(b.data.data())};
+
+            runner.measure("string_compare/pid::string", v.size(), others.size(), 0, [&] {
+                std::size_t less{0};
+                for (std::size_t i{0}; i < others.size(); ++i) {
+                    less += (v[i % v.size()] <=> others[i]) < 0;
+                }
+                do_not_optimize(less);
+            });
+        }
+
+        if (runner.enabled("string_compare/std::string")) {
+            runner.measure("string_compare/std::string", strings.size(), others.size(), 0, [&] {
+                std::size_t less{0};
+                for (std::size_t i{0}; i < others.size(); ++i) {
+                    less += (strings[i % strings.size()] <=> others[i]) < 0;
+                }
+                do_not_optimize(less);
+            });
+        }
+    }
+
+    void benchmark_build(benchmark_runner & runner, std::size_t size)
+    {
+        const auto strings{random_strings(size, common_prefix)};
+
+        if (runner.enabled("build/datastructure_builder::map")) {
+            std::map<std::string, std::int64_t> input;
+            for (std::size_t i{0}; i < strings.size(); ++i) {
+                input.emplace(strings[i], static_cast<std::int64_t>(i % 1000));
+            }
+
+            std::size_t bytes{0};
+            const auto build{[&] {
+                pid::builder b;
+                pid::datastructure_builder d_builder{b};
+                auto root{b.add<pid::map<pid::string, std::int64_t>>()};
+                *root = d_builder(input);
+                bytes = b.data.size();
+            }};
+            build();
+
+            runner.measure("build/datastructure_builder::map", size, size, bytes, build);
+        }
+
+        if (runner.enabled("build/datastructure_builder::vector")) {
+            // Each string occurs twice, such that the deduplication is measured, too
+            std::vector<std::string> input;
+            input.reserve(2 * strings.size());
+            for (std::size_t i{0}; i < 2 * strings.size(); ++i) {
+                input.push_back(strings[(i * 7919) % strings.size()]);
+            }
+
+            std::size_t bytes{0};
+            const auto build{[&] {
+                pid::builder b;
+                pid::datastructure_builder d_builder{b};
+                auto root{b.add<pid::vector<pid::string>>()};
+                *root = d_builder(input);
+                bytes = b.data.size();
+            }};
+            build();
+
+            runner.measure(
+                "build/datastructure_builder::vector", size, input.size(), bytes, build);
+        }
+    }
+
+    void benchmark_merge(benchmark_runner & runner, std::size_t size)
+    {
+        constexpr std::size_t sub_builder_count{16};
+        const std::size_t bytes_per_builder{size * sizeof(std::int64_t) / sub_builder_count};
+
+        std::vector<std::unique_ptr<pid::builder>> sub_builders;
+        std::vector<const pid::builder *> pointers;
+        for (std::size_t i{0}; i < sub_builder_count; ++i) {
+            sub_builders.push_back(std::make_unique<pid::builder>());
+            sub_builders.back()->add_vector<char, std::uint64_t>(bytes_per_builder);
+            pointers.push_back(sub_builders.back().get());
+        }
+        const std::size_t bytes{sub_builder_count * sub_builders.front()->data.size()};
+
+        if (runner.enabled("merge/add_sub_builder")) {
+            runner.measure("merge/add_sub_builder", size, sub_builder_count, bytes, [&] {
+                pid::builder b;
+                for (const auto & sub_builder : sub_builders) {
+                    b.add_sub_builder(*sub_builder);
+                }
+                do_not_optimize(b.data.size());
+            });
+        }
+
+        if (runner.enabled("merge/add_sub_builders")) {
+            runner.measure("merge/add_sub_builders", size, sub_builder_count, bytes, [&] {
+                pid::builder b;
+                b.add_sub_builders(std::span<const pid::builder * const>{pointers});
+                do_not_optimize(b.data.size());
+            });
+        }
+    }
+}
+
+int main(int argc, char ** argv)
+{
+    options o;
+
+    for (int i{1}; i < argc; ++i) {
+        const std::string argument{argv[i]};
+        if (i + 1 == argc) {
+            std::cerr << "missing value for " << argument << std::endl;
+            return 1;
+        }
+
+        if (argument == "--max-size") {
+            o.max_size = std::stoull(argv[++i]);
+        } else if (argument == "--filter") {
+            o.filter = argv[++i];
+        } else if (argument == "--output") {
+            o.output = argv[++i];
+        } else {
+            std::cerr << "usage: " << argv[0]
+                      << " [--max-size N] [--filter SUBSTRING] [--output FILE]" << std::endl;
+            return 1;
+        }
+    }
+
+    benchmark_runner runner{o};
+
+    for (const std::size_t size : runner.sizes()) {
+        benchmark_map_find<std::int64_t>(runner, "map_find_int", random_keys(size));
+        for (const std::string_view prefix : {std::string_view{}, common_prefix}) {
+            const std::string suffix{prefix.empty() ? "" : "_common_prefix"};
+            const auto keys{random_strings(size, prefix)};
+            benchmark_map_find<pid::string>(runner, "map_find_string" + suffix, keys);
+            benchmark_map_find<pid::prefix_string>(
+                runner, "map_find_prefix_string" + suffix, keys);
+        }
+        benchmark_vector_iteration(runner, size);
+        benchmark_build(runner, size);
+        benchmark_merge(runner, size);
+    }
+    benchmark_string_compare(runner);
+
+    if (o.output.empty()) {
+        runner.write_json(std::cout);
+    } else {
+        std::ofstream out{o.output};
+        runner.write_json(out);
+    }
+}
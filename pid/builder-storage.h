@@ -0,0 +1,481 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace pid {
+    // Contiguous, growable byte buffer that holds the data of a pid::builder.
+    //
+    // By default, the bytes live on the heap. Alternatively, the buffer can be backed by a
+    // memory-mapped file, such that the blob is written directly to its final location on disk.
+    // In that case, growing the buffer extends the file and remaps it without copying any data,
+    // and the memory usage is bounded by the kernel page cache rather than by the blob size.
+    //
+    // Like std::vector, the buffer may move in memory when it grows. This is fine for the builder
+    // because builder_offset refers to the data by offset.
+    //
+    // A third option is a fixed range of address space, which is reserved up front and never
+    // moves. Physical memory is only used for the pages that are written. With such storage,
+    // allocate() is thread-safe, such that several threads can add data concurrently.
+    //
+    // Finally, the data can be streamed to a file: flush() writes the data before a given
+    // offset, which the caller declares as final, and removes it from memory. Only the data
+    // behind the last flush are kept in a window on the heap, so blobs larger than the memory
+    // can be built. Offsets stay relative to the start of the blob, but only the bytes in
+    // [flushed_size(), size()) are in memory, and data() is the byte at flushed_size().
+    struct builder_storage
+    {
+        builder_storage() {}
+
+        builder_storage(const builder_storage &) = delete;
+
+        builder_storage(builder_storage && other) noexcept
+            : start{std::exchange(other.start, nullptr)},
+              length{other.length.exchange(0, std::memory_order_relaxed)},
+              reserved{std::exchange(other.reserved, 0)},
+              fd{std::exchange(other.fd, -1)},
+              fixed_address{std::exchange(other.fixed_address, false)},
+              streaming{std::exchange(other.streaming, false)},
+              flushed{std::exchange(other.flushed, 0)}
+        {
+        }
+
+        builder_storage & operator=(const builder_storage &) = delete;
+
+        builder_storage & operator=(builder_storage && other) noexcept
+        {
+            if (this != &other) {
+                release();
+                start = std::exchange(other.start, nullptr);
+                length.store(
+                    other.length.exchange(0, std::memory_order_relaxed),
+                    std::memory_order_relaxed);
+                reserved = std::exchange(other.reserved, 0);
+                fd = std::exchange(other.fd, -1);
+                fixed_address = std::exchange(other.fixed_address, false);
+                streaming = std::exchange(other.streaming, false);
+                flushed = std::exchange(other.flushed, 0);
+            }
+            return *this;
+        }
+
+        ~builder_storage()
+        {
+            release();
+        }
+
+        // Creates (or truncates) the file at 'path' and uses it as backing store. The file is
+        // truncated to the final data size when the storage is closed or destroyed.
+        static builder_storage mapped_file(const std::string & path)
+        {
+            builder_storage result;
+            result.fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+            if (result.fd < 0) {
+                throw std::system_error{errno, std::generic_category(), "Cannot open " + path};
+            }
+
+            return result;
+        }
+
+        // Creates (or truncates) the file at 'path' and streams the data to it, see flush().
+        // 'window_size' is the initial capacity of the window in memory, which grows if more
+        // data than that are added between two flushes.
+        static builder_storage streamed_file(
+            const std::string & path, std::size_t window_size = std::size_t{1} << 26)
+        {
+            builder_storage result{mapped_file(path)};
+            result.streaming = true;
+            result.reserve(window_size);
+            return result;
+        }
+
+        // Reserves 'max_size' bytes of address space. The storage cannot grow beyond this size,
+        // but it never moves, and allocate() may be called from several threads at once.
+        static builder_storage address_space(std::size_t max_size)
+        {
+            void * p{::mmap(
+                nullptr, max_size, PROT_READ | PROT_WRITE,
+                MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0)};
+            if (p == MAP_FAILED) {
+                throw std::system_error{
+                    errno, std::generic_category(), "Cannot reserve address space"};
+            }
+
+            builder_storage result;
+            result.start = static_cast<char *>(p);
+            result.reserved = max_size;
+            result.fixed_address = true;
+            return result;
+        }
+
+        bool is_mapped_file() const
+        {
+            return fd >= 0 and not streaming;
+        }
+
+        bool is_streamed_file() const
+        {
+            return streaming;
+        }
+
+        // Number of bytes at the start of the data which have been written to the file and
+        // cannot be accessed anymore. This is a multiple of flush_alignment.
+        std::size_t flushed_size() const
+        {
+            return flushed;
+        }
+
+        // Alignment of the flushed data. Objects with a larger alignment are not supported by
+        // streamed storage.
+        static constexpr std::size_t flush_alignment{4096};
+
+        // Writes the data before 'end' to the file and releases them from memory. The data must
+        // not be changed anymore, and pointers into them cannot be assigned anymore, but
+        // pointers to them can. Only whole multiples of flush_alignment are written, the rest
+        // is written by the next flush() or close().
+        void flush(std::size_t end)
+        {
+            if (not streaming) {
+                throw std::logic_error{"only streamed storage can be flushed"};
+            }
+            if (end > size()) {
+                throw std::out_of_range{"cannot flush data behind the end"};
+            }
+
+            end -= end % flush_alignment;
+            if (end <= flushed) {
+                return;
+            }
+
+            write_window(end - flushed);
+            std::memmove(start, start + (end - flushed), size() - end);
+            flushed = end;
+        }
+
+        bool has_fixed_address() const
+        {
+            return fixed_address;
+        }
+
+        // First byte in memory. For streamed storage, this is the byte at flushed_size(), and
+        // [begin(), end()) is the window.
+        char * data()
+        {
+            return start;
+        }
+
+        const char * data() const
+        {
+            return start;
+        }
+
+        // Address of the byte at 'offset' from the start of the blob, which must not be in
+        // front of flushed_size()
+        char * at(std::size_t offset)
+        {
+            return start + (offset - flushed);
+        }
+
+        const char * at(std::size_t offset) const
+        {
+            return start + (offset - flushed);
+        }
+
+        // Overwrites 'count' bytes at 'offset' with 'bytes'. For streamed storage, the part
+        // which has been flushed already is written to the file, e.g., to complete a header at
+        // the start of the blob.
+        void write(std::size_t offset, const void * bytes, std::size_t count)
+        {
+            if (offset > size() or count > size() - offset) {
+                throw std::out_of_range{"cannot write data behind the end"};
+            }
+
+            const char * source{static_cast<const char *>(bytes)};
+            if (offset < flushed) {
+                const std::size_t flushed_count{std::min(count, flushed - offset)};
+                write_file(offset, source, flushed_count);
+                offset += flushed_count;
+                source += flushed_count;
+                count -= flushed_count;
+            }
+
+            std::memcpy(at(offset), source, count);
+        }
+
+        std::size_t size() const
+        {
+            return length.load(std::memory_order_relaxed);
+        }
+
+        bool empty() const
+        {
+            return size() == 0;
+        }
+
+        std::size_t capacity() const
+        {
+            return reserved;
+        }
+
+        char * begin()
+        {
+            return data();
+        }
+
+        const char * begin() const
+        {
+            return data();
+        }
+
+        char * end()
+        {
+            return at(size());
+        }
+
+        const char * end() const
+        {
+            return at(size());
+        }
+
+        // Changes the size of the buffer. New bytes are zero-initialized.
+        void resize(std::size_t new_size)
+        {
+            if (new_size < flushed) {
+                throw std::logic_error{"cannot remove data which have been flushed"};
+            }
+
+            if (new_size - flushed > reserved) {
+                grow(new_size - flushed);
+            }
+
+            const std::size_t old_size{size()};
+            if (new_size > old_size) {
+                if (not fixed_address) {
+                    std::memset(at(old_size), 0, new_size - old_size);
+                }
+            } else if (fixed_address) {
+                // Bytes behind the end of fixed storage are kept zeroed, such that
+                // allocate() does not need to clear them
+                std::memset(start + new_size, 0, old_size - new_size);
+            }
+
+            length.store(new_size, std::memory_order_relaxed);
+        }
+
+        // Like resize(), but new bytes are not initialized, except for storage with a fixed
+        // address, where they are zero anyway. This saves writing every byte twice if the
+        // caller overwrites them right away.
+        void resize_uninitialized(std::size_t new_size)
+        {
+            if (fixed_address) {
+                resize(new_size);
+                return;
+            }
+
+            if (new_size < flushed) {
+                throw std::logic_error{"cannot remove data which have been flushed"};
+            }
+            if (new_size - flushed > reserved) {
+                grow(new_size - flushed);
+            }
+
+            length.store(new_size, std::memory_order_relaxed);
+        }
+
+        // Appends 'count' zero-initialized bytes, such that their address is a multiple of
+        // 'alignment', and returns their offset. This is thread-safe if the storage has a
+        // fixed address: threads claim disjoint ranges with an atomic compare-and-swap on the
+        // size, and no lock is needed to write to them.
+        std::size_t allocate(std::size_t count, std::size_t alignment)
+        {
+            if (not fixed_address) {
+                const std::size_t offset{aligned_offset(size(), alignment)};
+                resize(offset + count);
+                return offset;
+            }
+
+            std::size_t current{length.load(std::memory_order_relaxed)};
+            std::size_t offset;
+            do {
+                offset = aligned_offset(current, alignment);
+                if (offset > reserved or count > reserved - offset) {
+                    throw std::length_error{"reserved address space is exhausted"};
+                }
+            } while (not length.compare_exchange_weak(
+                current, offset + count, std::memory_order_relaxed));
+
+            return offset;
+        }
+
+        // Like allocate(), but the 'count' bytes are not initialized, see resize_uninitialized().
+        // The padding in front of them is still zeroed, such that the data are deterministic
+        // as long as the caller writes all bytes.
+        std::size_t allocate_uninitialized(std::size_t count, std::size_t alignment)
+        {
+            if (fixed_address) {
+                return allocate(count, alignment);
+            }
+
+            const std::size_t old_size{size()};
+            const std::size_t offset{aligned_offset(old_size, alignment)};
+            resize_uninitialized(offset + count);
+            std::memset(at(old_size), 0, offset - old_size);
+            return offset;
+        }
+
+        void reserve(std::size_t new_capacity)
+        {
+            if (new_capacity > reserved) {
+                set_capacity(new_capacity);
+            }
+        }
+
+        // Unmaps the file and truncates it to the size of the data. For heap storage, this just
+        // frees the memory, and for streamed storage, the rest of the data is written. In all
+        // cases, the storage is empty afterwards.
+        void close()
+        {
+            if (streaming) {
+                if (fd >= 0) {
+                    write_window(size() - flushed);
+                    const int closed_fd{std::exchange(fd, -1)};
+                    if (::close(closed_fd) != 0) {
+                        throw std::system_error{errno, std::generic_category(), "close failed"};
+                    }
+                }
+
+                std::free(start);
+                start = nullptr;
+                streaming = false;
+                flushed = 0;
+            } else if (fixed_address) {
+                if (start != nullptr and ::munmap(start, reserved) != 0) {
+                    throw std::system_error{errno, std::generic_category(), "munmap failed"};
+                }
+                start = nullptr;
+                fixed_address = false;
+            } else if (is_mapped_file()) {
+                if (start != nullptr and ::munmap(start, reserved) != 0) {
+                    throw std::system_error{errno, std::generic_category(), "munmap failed"};
+                }
+                start = nullptr;
+
+                if (::ftruncate(fd, static_cast<off_t>(size())) != 0) {
+                    throw std::system_error{errno, std::generic_category(), "ftruncate failed"};
+                }
+
+                const int closed_fd{std::exchange(fd, -1)};
+                if (::close(closed_fd) != 0) {
+                    throw std::system_error{errno, std::generic_category(), "close failed"};
+                }
+            } else {
+                std::free(start);
+                start = nullptr;
+            }
+
+            length.store(0, std::memory_order_relaxed);
+            reserved = 0;
+        }
+
+    private:
+        char * start{nullptr};
+        std::atomic<std::size_t> length{0};
+        std::size_t reserved{0};
+        int fd{-1};
+        bool fixed_address{false};
+        bool streaming{false};
+
+        // Bytes which have been written to the file by flush()
+        std::size_t flushed{0};
+
+        // Returns the first offset at or behind 'offset' whose address is a multiple of
+        // 'alignment'
+        std::size_t aligned_offset(std::size_t offset, std::size_t alignment) const
+        {
+            const std::size_t address{reinterpret_cast<std::size_t>(start) + (offset - flushed)};
+            return offset + (alignment - address % alignment) % alignment;
+        }
+
+        void grow(std::size_t required)
+        {
+            // Grow geometrically to get amortized constant cost per added byte.
+            constexpr std::size_t minimum_capacity{64};
+            set_capacity(std::max({required, 2 * reserved, minimum_capacity}));
+        }
+
+        void set_capacity(std::size_t new_capacity)
+        {
+            if (fixed_address) {
+                throw std::length_error{"reserved address space is exhausted"};
+            }
+
+            if (is_mapped_file()) {
+                if (::ftruncate(fd, static_cast<off_t>(new_capacity)) != 0) {
+                    throw std::system_error{errno, std::generic_category(), "ftruncate failed"};
+                }
+
+                // mremap does not copy the data, it only changes the page table entries.
+                void * p{
+                    start == nullptr
+                        ? ::mmap(nullptr, new_capacity, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0)
+                        : ::mremap(start, reserved, new_capacity, MREMAP_MAYMOVE)};
+                if (p == MAP_FAILED) {
+                    throw std::system_error{errno, std::generic_category(), "Cannot map file"};
+                }
+                start = static_cast<char *>(p);
+            } else {
+                void * p{std::realloc(start, new_capacity)};
+                if (p == nullptr) {
+                    throw std::bad_alloc{};
+                }
+                start = static_cast<char *>(p);
+            }
+
+            reserved = new_capacity;
+        }
+
+        // Writes the first 'count' bytes of the window to the file
+        void write_window(std::size_t count)
+        {
+            write_file(flushed, start, count);
+        }
+
+        void write_file(std::size_t offset, const char * p, std::size_t count)
+        {
+            while (count > 0) {
+                const ssize_t written{::pwrite(fd, p, count, static_cast<off_t>(offset))};
+                if (written < 0) {
+                    if (errno == EINTR) {
+                        continue;
+                    }
+                    throw std::system_error{errno, std::generic_category(), "write failed"};
+                }
+
+                p += written;
+                offset += static_cast<std::size_t>(written);
+                count -= static_cast<std::size_t>(written);
+            }
+        }
+
+        void release() noexcept
+        {
+            try {
+                close();
+            } catch (...) {
+                // Destructors must not throw. Call close() explicitly to get error reporting.
+            }
+        }
+    };
+}
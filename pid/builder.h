@@ -1,33 +1,188 @@
 #pragma once
 
 #include "pid.h"
+#include "builder-storage.h"
+
+#include <array>
+#include <atomic>
+#include <numeric>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
 
 namespace pid {
     template <typename Key, typename Value, typename SizeType>
     struct generic_map_builder;
 
+    template <typename Key, typename Value, typename SizeType>
+    struct generic_eytzinger_map_builder;
+
+    template <typename Key, typename Value, typename SizeType>
+    struct generic_hash_map_builder;
+
+    template <typename Key, typename Value, typename SizeType>
+    struct generic_soa_map_builder;
+
+    template <typename Key, typename Value, typename SizeType>
+    struct generic_s_tree_map_builder;
+
     struct builder_offset_mover;
 
+    // Thrown if the distance between a pointer and its target does not fit into the offset
+    // type of the pointer
+    struct pointer_too_far : std::out_of_range
+    {
+        pointer_too_far() : std::out_of_range{"Pointer is too far away"} {}
+    };
+
+    namespace detail {
+        // Symbol table of a compressed string vector while it is being built, with the same
+        // representation as in detail::generic_compressed_string_vector_data
+        struct symbol_table
+        {
+            std::vector<char> symbols;
+            std::vector<std::uint8_t> lengths;
+
+            std::size_t size() const
+            {
+                return lengths.size();
+            }
+
+            template <typename Output>
+            bool encode(std::string_view s, Output output) const
+            {
+                return encode_with_symbols(symbols.data(), lengths.data(), size(), s, output);
+            }
+
+            // Replaces the symbols and sorts them as required by encode_with_symbols()
+            void assign(std::vector<std::string> new_symbols)
+            {
+                std::sort(
+                    new_symbols.begin(), new_symbols.end(),
+                    [](const std::string & a, const std::string & b) {
+                        const auto a_first{static_cast<unsigned char>(a[0])};
+                        const auto b_first{static_cast<unsigned char>(b[0])};
+                        if (a_first != b_first) {
+                            return a_first < b_first;
+                        }
+                        if (a.size() != b.size()) {
+                            return a.size() > b.size();
+                        }
+                        return a < b;
+                    });
+
+                symbols.assign(new_symbols.size() * 8, '\0');
+                lengths.resize(new_symbols.size());
+                for (std::size_t i{0}; i < new_symbols.size(); ++i) {
+                    std::memcpy(&symbols[i * 8], new_symbols[i].data(), new_symbols[i].size());
+                    lengths[i] = static_cast<std::uint8_t>(new_symbols[i].size());
+                }
+            }
+        };
+
+        // Trains a symbol table on a sample of about 'sample_size' characters of 'strings',
+        // like FSST: the sample is encoded with the current table, and the next table consists
+        // of the symbols and concatenations of two adjacent symbols which would have covered
+        // the most characters. Starting with an empty table, this is repeated a few times.
+        template <typename Strings>
+        symbol_table train_symbol_table(const Strings & strings, std::size_t sample_size = 1 << 16)
+        {
+            constexpr std::size_t max_symbols{255};
+            constexpr std::size_t max_symbol_length{8};
+            constexpr int rounds{5};
+
+            std::size_t characters{0};
+            for (const auto & s : strings) {
+                characters += std::string_view{s}.size();
+            }
+            const std::size_t stride{std::max<std::size_t>(1, characters / sample_size)};
+
+            symbol_table result;
+            std::unordered_map<std::string, std::size_t> gains;
+            for (int round{0}; round < rounds; ++round) {
+                gains.clear();
+
+                std::size_t index{0};
+                for (const auto & item : strings) {
+                    if (index++ % stride != 0) {
+                        continue;
+                    }
+
+                    const std::string_view s{item};
+                    std::size_t position{0};
+                    std::string_view previous;
+                    bool escaped{false};
+                    result.encode(s, [&](std::uint8_t code) {
+                        if (code == symbol_escape_code and not escaped) {
+                            escaped = true;
+                            return true;
+                        }
+
+                        const std::size_t length{escaped ? std::size_t{1} : result.lengths[code]};
+                        const std::string_view symbol{s.substr(position, length)};
+                        gains[std::string{symbol}] += symbol.size();
+                        if (not previous.empty()
+                            and previous.size() + symbol.size() <= max_symbol_length) {
+                            gains[std::string{previous.data(), previous.size() + symbol.size()}] +=
+                                previous.size() + symbol.size();
+                        }
+
+                        previous = symbol;
+                        position += length;
+                        escaped = false;
+                        return true;
+                    });
+                }
+
+                std::vector<std::pair<std::size_t, std::string>> candidates;
+                candidates.reserve(gains.size());
+                for (auto & [symbol, gain] : gains) {
+                    candidates.emplace_back(gain, symbol);
+                }
+
+                const std::size_t count{std::min(max_symbols, candidates.size())};
+                std::partial_sort(
+                    candidates.begin(), candidates.begin() + static_cast<std::ptrdiff_t>(count),
+                    candidates.end(), [](const auto & a, const auto & b) {
+                        return a.first != b.first ? a.first > b.first : a.second < b.second;
+                    });
+
+                std::vector<std::string> symbols;
+                for (std::size_t i{0}; i < count; ++i) {
+                    symbols.push_back(std::move(candidates[i].second));
+                }
+                result.assign(std::move(symbols));
+            }
+
+            return result;
+        }
+    }
+
     struct builder
     {
         builder() {}
 
+        explicit builder(builder_storage storage) : data{std::move(storage)} {}
+
         builder(const builder &) = delete;
 
         builder(builder &&) = delete;
 
-        std::vector<char> data;
+        builder_storage data;
 
         template <typename T>
         builder_offset<T> convert_to_builder_offset(T * p)
         {
             auto c{reinterpret_cast<const char *>(p)};
-            if (c < data.data() or c > data.data() + data.size()) {
+            if (c < data.begin() or c > data.end()) {
                 throw std::out_of_range{"Pointer does not point to builder data"};
             }
 
             const std::size_t offset{
-                static_cast<std::size_t>(reinterpret_cast<char *>(p) - data.data())};
+                data.flushed_size() + static_cast<std::size_t>(c - data.data())};
 
             return {*this, offset};
         }
@@ -35,8 +190,7 @@ namespace pid {
         template <typename T>
         std::size_t next_offset() const
         {
-            const std::size_t current_ptr{
-                reinterpret_cast<const std::size_t>(data.data()) + data.size()};
+            const std::size_t current_ptr{reinterpret_cast<const std::size_t>(data.end())};
             constexpr std::size_t alignment{alignof(T)};
             constexpr std::size_t alignment_mask{
                 std::numeric_limits<std::size_t>::max() << (alignment - 1)};
@@ -44,11 +198,31 @@ namespace pid {
             return data.size() + padding;
         }
 
+        // Thread-safe if the storage has a fixed address, see builder_storage::address_space().
+        // This also applies to all functions below which add data.
         template <typename T>
         builder_offset<T> add(std::size_t extra_bytes = 0)
         {
-            const auto offset{next_offset<T>()};
-            data.resize(offset + sizeof(T) + extra_bytes);
+            return {*this, data.allocate(sizeof(T) + extra_bytes, alignof(T))};
+        }
+
+        // Like add(), but the 'extra_bytes' behind the object are not initialized, which saves
+        // writing them twice if the caller overwrites them anyway. The caller must write all
+        // of them, such that the data stay deterministic.
+        //
+        // If T ends with a flexible array member, the member may start in the tail padding of
+        // T, before the extra bytes. The caller then writes 'extra_bytes' bytes from the start
+        // of the member, and the last bytes of the allocation are never written, so they are
+        // zeroed here. Tail padding is always shorter than alignof(T).
+        template <typename T>
+        builder_offset<T> add_uninitialized(std::size_t extra_bytes)
+        {
+            const std::size_t size{sizeof(T) + extra_bytes};
+            const std::size_t offset{data.allocate_uninitialized(size, alignof(T))};
+            const std::size_t tail{std::min(extra_bytes, alignof(T))};
+
+            std::memset(data.at(offset), 0, sizeof(T));
+            std::memset(data.at(offset + size - tail), 0, tail);
             return {*this, offset};
         }
 
@@ -56,7 +230,7 @@ namespace pid {
         builder_offset<detail::generic_string_data<SizeType>> add_string(std::string_view s)
         {
             const auto size{s.size()};
-            auto result{add<detail::generic_string_data<SizeType>>(
+            auto result{add_uninitialized<detail::generic_string_data<SizeType>>(
                 size + 1)};  // add 1 for null terminator
             result->string_length = size;
             std::memcpy(result->data, s.begin(), s.size());
@@ -65,6 +239,29 @@ namespace pid {
             return result;
         }
 
+        // Adds a string for a generic_hashed_string, together with its hash
+        template <typename SizeType = std::uint32_t>
+        builder_offset<detail::generic_hashed_string_data<SizeType>> add_hashed_string(
+            std::string_view s)
+        {
+            using DataType = detail::generic_hashed_string_data<SizeType>;
+
+            // The characters start in the tail padding of DataType, so the last bytes of the
+            // allocation are not written here. add_uninitialized() zeroes them.
+            const auto size{s.size()};
+            auto result{add_uninitialized<DataType>(size + 1)};  // add 1 for null terminator
+            result->string_hash = DataType::hash_of(s);
+            result->string_length = size;
+            std::memcpy(result->data, s.begin(), s.size());
+            result->data[s.size()] = 0;
+
+            return result;
+        }
+
+        // Adds the characters of a string for a generic_prefix_string, if it is too long to be
+        // stored in the handle. The result must be assigned to the handle.
+        prefix_string_offset add_prefix_string(std::string_view s);
+
         template <typename T, typename SizeType>
         builder_offset<detail::generic_vector_data<T, SizeType>> add_vector(SizeType size)
         {
@@ -74,6 +271,232 @@ namespace pid {
             return result;
         }
 
+        // Like add_vector(), but the items are not initialized. The caller must write all of
+        // them. T must not contain padding, which the caller could not write.
+        template <typename T, typename SizeType>
+        builder_offset<detail::generic_vector_data<T, SizeType>> add_vector_uninitialized(
+            SizeType size)
+        {
+            static_assert(
+                std::has_unique_object_representations_v<T> or std::is_floating_point_v<T>,
+                "the items must not contain padding");
+
+            auto result{add_uninitialized<detail::generic_vector_data<T, SizeType>>(
+                size * sizeof(T))};
+            result->vector_length = size;
+
+            return result;
+        }
+
+        // Adds a bit-packed copy of 'values', see detail::generic_packed_vector_data
+        template <typename T, typename SizeType>
+        builder_offset<detail::generic_packed_vector_data<T, SizeType>> add_packed_vector(
+            std::span<const T> values)
+        {
+            using DataType = detail::generic_packed_vector_data<T, SizeType>;
+
+            if (values.size() > std::numeric_limits<SizeType>::max()) {
+                throw std::out_of_range{"too many values for the size type"};
+            }
+
+            const std::size_t block_count{DataType::block_count(values.size())};
+
+            // The values are converted to std::uint64_t, such that the differences to the block
+            // minimum can be computed with modular arithmetic also for signed types.
+            std::vector<std::uint64_t> block_minimum(block_count);
+            std::vector<unsigned> bit_width(block_count);
+            std::size_t bit_count{0};
+            for (std::size_t block{0}; block < block_count; ++block) {
+                const auto first{values.begin() + block * DataType::block_size};
+                const auto last{
+                    values.begin()
+                    + std::min(values.size(), (block + 1) * DataType::block_size)};
+                const auto [minimum, maximum] = std::minmax_element(first, last);
+
+                block_minimum[block] = static_cast<std::uint64_t>(*minimum);
+                bit_width[block] = static_cast<unsigned>(
+                    std::bit_width(static_cast<std::uint64_t>(*maximum) - block_minimum[block]));
+                bit_count += static_cast<std::size_t>(last - first) * bit_width[block];
+            }
+
+            const std::size_t word_count{DataType::word_count(values.size(), bit_count)};
+            auto result{add<DataType>(word_count * sizeof(std::uint64_t))};
+            result->vector_length = static_cast<SizeType>(values.size());
+
+            std::uint64_t * words{result->words};
+            std::uint64_t * packed{words + 2 * block_count};
+            std::size_t bit{0};
+            for (std::size_t block{0}; block < block_count; ++block) {
+                const unsigned width{bit_width[block]};
+                words[2 * block] = block_minimum[block];
+                words[2 * block + 1] = DataType::block_position(bit, width);
+
+                const std::size_t last{
+                    std::min(values.size(), (block + 1) * DataType::block_size)};
+                for (std::size_t index{block * DataType::block_size}; index < last; ++index) {
+                    const std::uint64_t difference{
+                        static_cast<std::uint64_t>(values[index]) - block_minimum[block]};
+                    const std::size_t shift{bit % 64};
+
+                    packed[bit / 64] |= difference << shift;
+                    if (shift + width > 64) {
+                        packed[bit / 64 + 1] |= difference >> (64 - shift);
+                    }
+                    bit += width;
+                }
+            }
+
+            return result;
+        }
+
+        // Adds a vector of strings which are stored contiguously, see
+        // detail::generic_string_vector_data. 'strings' is a range of values which are
+        // convertible to std::string_view.
+        template <typename SizeType, typename Strings>
+        builder_offset<detail::generic_string_vector_data<SizeType>> add_string_vector(
+            const Strings & strings)
+        {
+            using DataType = detail::generic_string_vector_data<SizeType>;
+
+            std::size_t size{0};
+            std::size_t characters{0};
+            for (const auto & s : strings) {
+                ++size;
+                characters += std::string_view{s}.size();
+            }
+
+            if (size > std::numeric_limits<SizeType>::max()
+                or characters > std::numeric_limits<SizeType>::max()) {
+                throw std::out_of_range{"too many strings or characters for the size type"};
+            }
+
+            auto result{add<DataType>(DataType::extra_bytes(size, characters))};
+            result->vector_length = static_cast<SizeType>(size);
+
+            DataType & d{*result};
+            std::size_t index{0};
+            SizeType offset{0};
+            for (const auto & s : strings) {
+                const std::string_view view{s};
+                d.offsets[index++] = offset;
+                std::memcpy(d.characters() + offset, view.data(), view.size());
+                offset += static_cast<SizeType>(view.size());
+            }
+            d.offsets[size] = offset;
+
+            return result;
+        }
+
+        // Adds a vector of strings which are compressed with a symbol table that is trained on
+        // the strings, see detail::generic_compressed_string_vector_data
+        template <typename SizeType, typename Strings>
+        builder_offset<detail::generic_compressed_string_vector_data<SizeType>>
+        add_compressed_string_vector(const Strings & strings)
+        {
+            using DataType = detail::generic_compressed_string_vector_data<SizeType>;
+
+            const detail::symbol_table table{detail::train_symbol_table(strings)};
+
+            std::vector<char> codes;
+            std::vector<std::size_t> ends;
+            for (const auto & s : strings) {
+                table.encode(std::string_view{s}, [&](std::uint8_t code) {
+                    codes.push_back(static_cast<char>(code));
+                    return true;
+                });
+                ends.push_back(codes.size());
+            }
+
+            if (ends.size() > std::numeric_limits<SizeType>::max()
+                or codes.size() > std::numeric_limits<SizeType>::max()) {
+                throw std::out_of_range{"too many strings or characters for the size type"};
+            }
+
+            auto result{
+                add<DataType>(DataType::extra_bytes(ends.size(), table.size(), codes.size()))};
+            result->vector_length = static_cast<SizeType>(ends.size());
+            result->symbol_count = static_cast<SizeType>(table.size());
+
+            DataType & d{*result};
+            d.offsets[0] = 0;
+            for (std::size_t i{0}; i < ends.size(); ++i) {
+                d.offsets[i + 1] = static_cast<SizeType>(ends[i]);
+            }
+            std::memcpy(d.symbols(), table.symbols.data(), table.symbols.size());
+            std::memcpy(d.symbol_lengths(), table.lengths.data(), table.lengths.size());
+            std::memcpy(d.codes(), codes.data(), codes.size());
+
+            return result;
+        }
+
+        // Adds a vector of optional values with a validity bitmap, see
+        // detail::generic_optional_vector_data
+        template <typename T, typename SizeType>
+        builder_offset<detail::generic_optional_vector_data<T, SizeType>> add_optional_vector(
+            std::span<const std::optional<T>> values)
+        {
+            using DataType = detail::generic_optional_vector_data<T, SizeType>;
+
+            if (values.size() > std::numeric_limits<SizeType>::max()) {
+                throw std::out_of_range{"too many values for the size type"};
+            }
+
+            auto result{add<DataType>(DataType::extra_bytes(values.size()))};
+            result->vector_length = static_cast<SizeType>(values.size());
+
+            for (std::size_t index{0}; index < values.size(); ++index) {
+                if (values[index]) {
+                    detail::set_bit(result->validity, index);
+                    result->values()[index] = *values[index];
+                }
+            }
+
+            return result;
+        }
+
+        // Adds a vector of optional strings with a validity bitmap, see
+        // detail::generic_optional_string_vector_data. 'strings' is a range of std::optional
+        // values which are convertible to std::string_view.
+        template <typename SizeType, typename Strings>
+        builder_offset<detail::generic_optional_string_vector_data<SizeType>>
+        add_optional_string_vector(const Strings & strings)
+        {
+            using DataType = detail::generic_optional_string_vector_data<SizeType>;
+
+            std::size_t size{0};
+            std::size_t characters{0};
+            for (const auto & s : strings) {
+                ++size;
+                if (s) {
+                    characters += std::string_view{*s}.size();
+                }
+            }
+
+            if (size > std::numeric_limits<SizeType>::max()
+                or characters > std::numeric_limits<SizeType>::max()) {
+                throw std::out_of_range{"too many strings or characters for the size type"};
+            }
+
+            auto result{add<DataType>(DataType::extra_bytes(size, characters))};
+            result->vector_length = static_cast<SizeType>(size);
+
+            std::size_t index{0};
+            SizeType offset{0};
+            for (const auto & s : strings) {
+                result->offsets()[index] = offset;
+                if (s) {
+                    const std::string_view view{*s};
+                    detail::set_bit(result->validity, index);
+                    std::memcpy(result->characters() + offset, view.data(), view.size());
+                    offset += static_cast<SizeType>(view.size());
+                }
+                ++index;
+            }
+            result->offsets()[size] = offset;
+
+            return result;
+        }
+
         template <typename Key, typename Value, typename SizeType>
         generic_map_builder<Key, Value, SizeType> add_map(SizeType size)
         {
@@ -85,6 +508,55 @@ namespace pid {
             return MapBuilderType{items};
         }
 
+        template <typename Key, typename Value, typename SizeType>
+        generic_eytzinger_map_builder<Key, Value, SizeType> add_eytzinger_map(SizeType size)
+        {
+            using MapBuilderType = generic_eytzinger_map_builder<Key, Value, SizeType>;
+            using ItemType = typename MapBuilderType::ItemType;
+            using VectorDataType = typename MapBuilderType::VectorDataType;
+
+            const builder_offset<VectorDataType> items{add_vector<ItemType, SizeType>(size)};
+            return MapBuilderType{items};
+        }
+
+        // 'keys' is a range that contains all keys of the map, which are needed to build the
+        // perfect hash function. The keys must be integers, enums, or strings.
+        template <typename Key, typename Value, typename SizeType, typename Keys>
+        generic_hash_map_builder<Key, Value, SizeType> add_hash_map(const Keys & keys)
+        {
+            return generic_hash_map_builder<Key, Value, SizeType>{*this, keys};
+        }
+
+        template <typename Key, typename Value, typename SizeType>
+        generic_soa_map_builder<Key, Value, SizeType> add_soa_map(SizeType size)
+        {
+            return {add_vector<Key, SizeType>(size), add_vector<Value, SizeType>(size)};
+        }
+
+        // The search tree is stored behind the items, and it is filled while the keys are added
+        template <typename Key, typename Value, typename SizeType>
+        generic_s_tree_map_builder<Key, Value, SizeType> add_s_tree_map(SizeType size)
+        {
+            using IndexDataType = detail::generic_s_tree_data<Key, SizeType>;
+
+            auto items{add_vector<std::pair<Key, Value>, SizeType>(size)};
+            auto index{add<IndexDataType>(IndexDataType::extra_bytes(size))};
+            index->set_key_count(size);
+
+            // Relative to the offset rather than the address, such that the blob is
+            // deterministic
+            const std::size_t keys_offset{index.offset + sizeof(IndexDataType)};
+            index->padding = static_cast<SizeType>(
+                (IndexDataType::cache_line_size - keys_offset % IndexDataType::cache_line_size)
+                % IndexDataType::cache_line_size);
+
+            Key * const keys{index->keys()};
+            std::fill(
+                keys, keys + IndexDataType::index_size(size), std::numeric_limits<Key>::max());
+
+            return {items, index};
+        }
+
         struct builder_offset_mover
         {
             builder & destination;
@@ -109,15 +581,88 @@ namespace pid {
         };
 
         // By default, we assume that the data in 'other' needs 64-bit alignment.
+        //
+        // If the storage has a fixed address, several threads may add their sub builders
+        // concurrently. Each thread only claims its range atomically and copies its data without
+        // holding a lock.
         template <typename AlignmentType = std::uint64_t>
         builder_offset_mover add_sub_builder(const builder & other)
         {
-            const auto offset{next_offset<AlignmentType>()};
-            data.resize(offset + other.data.size());
-            std::memcpy(data.data() + offset, other.data.data(), other.data.size());
+            const auto offset{data.allocate(other.data.size(), alignof(AlignmentType))};
+            std::memcpy(data.at(offset), other.data.data(), other.data.size());
 
             return builder_offset_mover{*this, other, offset};
         }
+
+        // Adds the data of several sub builders at once and returns one mover for each of
+        // them. The destination offsets are computed up front with a prefix sum over the
+        // sizes, such that the whole range is allocated once, and the data are copied by up to
+        // 'thread_count' threads in chunks of merge_chunk_size bytes.
+        template <typename AlignmentType = std::uint64_t>
+        std::vector<builder_offset_mover> add_sub_builders(
+            std::span<const builder * const> others,
+            std::size_t thread_count = std::thread::hardware_concurrency())
+        {
+            constexpr std::size_t alignment{alignof(AlignmentType)};
+
+            std::vector<std::size_t> offsets(others.size() + 1, 0);
+            for (std::size_t i{0}; i < others.size(); ++i) {
+                const std::size_t size{others[i]->data.size()};
+                offsets[i + 1] = offsets[i] + (size + alignment - 1) / alignment * alignment;
+            }
+
+            // The copies write all bytes except for the alignment gaps, which are zeroed
+            // below, so the range is not cleared on this thread first
+            const std::size_t base{data.allocate_uninitialized(offsets.back(), alignment)};
+            for (std::size_t i{0}; i < others.size(); ++i) {
+                const std::size_t end{offsets[i] + others[i]->data.size()};
+                std::memset(data.at(base + end), 0, offsets[i + 1] - end);
+            }
+
+            // Split the data into chunks of similar size, such that a single large sub
+            // builder is also copied by several threads
+            struct chunk
+            {
+                const char * source;
+                std::size_t destination;
+                std::size_t size;
+            };
+
+            std::vector<chunk> chunks;
+            for (std::size_t i{0}; i < others.size(); ++i) {
+                const std::size_t size{others[i]->data.size()};
+                for (std::size_t first{0}; first < size; first += merge_chunk_size) {
+                    chunks.push_back(
+                        {others[i]->data.data() + first, base + offsets[i] + first,
+                         std::min(merge_chunk_size, size - first)});
+                }
+            }
+
+            std::atomic<std::size_t> next_chunk{0};
+            const auto copy_chunks{[&] {
+                for (std::size_t i{next_chunk++}; i < chunks.size(); i = next_chunk++) {
+                    const chunk & c{chunks[i]};
+                    std::memcpy(data.at(c.destination), c.source, c.size);
+                }
+            }};
+
+            {
+                std::vector<std::jthread> threads;
+                for (std::size_t i{1}; i < std::min(thread_count, chunks.size()); ++i) {
+                    threads.emplace_back(copy_chunks);
+                }
+                copy_chunks();
+            }
+
+            std::vector<builder_offset_mover> result;
+            result.reserve(others.size());
+            for (std::size_t i{0}; i < others.size(); ++i) {
+                result.push_back(builder_offset_mover{*this, *others[i], base + offsets[i]});
+            }
+            return result;
+        }
+
+        static constexpr std::size_t merge_chunk_size{std::size_t{1} << 20};
     };
 
     template <typename T>
@@ -152,21 +697,22 @@ namespace pid {
             if (*this) {
                 const char * dest_position{reinterpret_cast<const char *>(&dest)};
 
-                {
-                    const char * builder_data_start{b.data.data()};
-                    const char * builder_data_end{b.data.data() + b.data.size()};
-
-                    if (dest_position < builder_data_start or dest_position >= builder_data_end) {
-                        throw std::invalid_argument{
-                            "Pointer does not belong to the data of the correct builder"};
-                    }
+                // Flushed data are not in memory, so a destination in them does not belong to
+                // the builder either
+                if (dest_position < b.data.begin() or dest_position >= b.data.end()) {
+                    throw std::invalid_argument{
+                        "Pointer does not belong to the data of the correct builder"};
                 }
 
-                const std::ptrdiff_t offset64 =
-                    reinterpret_cast<const char *>(&**this) - dest_position;
+                // The target may have been flushed, so it is not dereferenced
+                const std::size_t dest_offset{
+                    b.data.flushed_size()
+                    + static_cast<std::size_t>(dest_position - b.data.data())};
+                const std::ptrdiff_t offset64 = static_cast<std::ptrdiff_t>(offset)
+                                                - static_cast<std::ptrdiff_t>(dest_offset);
                 if (offset64 < std::numeric_limits<offset_type>::min()
                     or offset64 > std::numeric_limits<offset_type>::max()) {
-                    throw std::out_of_range{"Pointer is too far away"};
+                    throw pointer_too_far{};
                 }
                 dest.offset = static_cast<offset_type>(offset64);
             } else {
@@ -184,14 +730,26 @@ namespace pid {
             return *operator->();
         }
 
+        // Throws std::logic_error if the object has been flushed, since it is not in memory
+        // anymore, see builder_storage::flush()
         T * operator->()
         {
-            return reinterpret_cast<T *>(b.data.data() + offset);
+            check_not_flushed();
+            return reinterpret_cast<T *>(b.data.at(offset));
         }
 
         const T * operator->() const
         {
-            return reinterpret_cast<const T *>(b.data.data() + offset);
+            check_not_flushed();
+            return reinterpret_cast<const T *>(b.data.at(offset));
+        }
+
+    private:
+        void check_not_flushed() const
+        {
+            if (offset < b.data.flushed_size()) {
+                throw std::logic_error{"Object is in data which have been flushed"};
+            }
         }
     };
 
@@ -253,4 +811,459 @@ namespace pid {
         }
     };
 
+    // Builds a generic_eytzinger_map. Like for generic_map_builder, the keys must be added in
+    // ascending order, and each item is placed at its position in the Eytzinger layout.
+    template <typename Key, typename Value, typename SizeType>
+    struct generic_eytzinger_map_builder
+    {
+        using ItemType = std::pair<Key, Value>;
+        using VectorDataType = detail::generic_vector_data<ItemType, SizeType>;
+
+        builder_offset<VectorDataType> items;
+        SizeType current_size{0};
+
+        // Index in 'items' for each rank in the sorted order of the keys
+        std::vector<SizeType> positions;
+
+        generic_eytzinger_map_builder(builder_offset<VectorDataType> items)
+            : items{items}, positions(items->size())
+        {
+            // In-order traversal of the implicit tree with 1-based indices
+            const std::size_t n{positions.size()};
+            std::size_t k{1};
+            while (2 * k <= n) {
+                k = 2 * k;
+            }
+
+            for (auto & position : positions) {
+                position = static_cast<SizeType>(k - 1);
+
+                if (2 * k + 1 <= n) {
+                    // Leftmost item in the right subtree
+                    k = 2 * k + 1;
+                    while (2 * k <= n) {
+                        k = 2 * k;
+                    }
+                } else {
+                    // Go up until we arrive from a left child
+                    k >>= std::countr_one(k) + 1;
+                }
+            }
+        }
+
+        builder_offset<detail::generic_vector_data<ItemType, SizeType>> offset() const
+        {
+            return {items.b, items.offset};
+        }
+
+        builder_offset<Value> add_key(const Key & key)
+        {
+            if (current_size == items->size()) {
+                throw std::out_of_range{"map is full"};
+            }
+
+            if (current_size > 0 and not(previous_item().first < key)) {
+                throw std::logic_error{"unsorted"};
+            }
+
+            auto & item{(*items)[positions[current_size]]};
+            item.first = key;
+
+            auto result{items.b.convert_to_builder_offset(&item.second)};
+            ++current_size;
+
+            return result;
+        }
+
+        template <typename Pointer>
+        builder_offset<Value> add_key(Pointer p)
+        {
+            if (current_size == items->size()) {
+                throw std::out_of_range{"map is full"};
+            }
+
+            if (current_size > 0) {
+                const auto & last_key{previous_item().first};
+                if (not(last_key < *p)) {
+                    throw std::logic_error{"unsorted"};
+                }
+            }
+
+            auto & item{(*items)[positions[current_size]]};
+            item.first = p;
+
+            auto result{items.b.convert_to_builder_offset(&item.second)};
+            ++current_size;
+
+            return result;
+        }
+
+    private:
+        const ItemType & previous_item() const
+        {
+            return (*items)[positions[current_size - 1]];
+        }
+    };
+
+    // Builds a generic_hash_map. The perfect hash function is computed from the complete set of
+    // keys when the builder is created. After that, the keys can be added in any order.
+    template <typename Key, typename Value, typename SizeType>
+    struct generic_hash_map_builder
+    {
+        using DataType = detail::generic_hash_map_data<Key, Value, SizeType>;
+        using ItemType = typename DataType::ItemType;
+
+        // Average number of keys per bucket. Larger buckets need less space for the pilots, but
+        // it takes longer to find pilots for them.
+        static constexpr std::size_t average_bucket_size{4};
+
+        builder_offset<DataType> data;
+
+        // Hash of the key that belongs to each position, and whether it was added already
+        std::vector<std::uint64_t> expected_hashes;
+        std::vector<bool> occupied;
+
+        template <typename Keys>
+        generic_hash_map_builder(builder & b, const Keys & keys)
+            : generic_hash_map_builder{b, build_hash_function(keys)}
+        {
+        }
+
+        builder_offset<DataType> offset() const
+        {
+            return data;
+        }
+
+        builder_offset<Value> add_key(const Key & key)
+        {
+            auto & item{item_for_hash(detail::hash_key(key, data->seed))};
+            item.first = key;
+
+            return data.b.convert_to_builder_offset(&item.second);
+        }
+
+        template <typename Pointer>
+        builder_offset<Value> add_key(Pointer p)
+        {
+            auto & item{item_for_hash(detail::hash_key(*p, data->seed))};
+            item.first = p;
+
+            return data.b.convert_to_builder_offset(&item.second);
+        }
+
+    private:
+        struct hash_function
+        {
+            std::uint64_t seed;
+            std::vector<std::uint64_t> hashes;
+            std::vector<std::uint32_t> pilots;
+        };
+
+        generic_hash_map_builder(builder & b, hash_function f)
+            : data{b.add<DataType>(DataType::extra_bytes(f.hashes.size(), f.pilots.size()))},
+              expected_hashes(f.hashes.size()),
+              occupied(f.hashes.size())
+        {
+            data->seed = f.seed;
+            data->map_size = static_cast<SizeType>(f.hashes.size());
+            data->bucket_count = static_cast<SizeType>(f.pilots.size());
+            std::copy(f.pilots.begin(), f.pilots.end(), data->pilots);
+
+            for (const auto hash : f.hashes) {
+                expected_hashes[data->position(hash)] = hash;
+            }
+        }
+
+        ItemType & item_for_hash(std::uint64_t hash)
+        {
+            const auto position{data->position(hash)};
+
+            if (expected_hashes[position] != hash) {
+                throw std::invalid_argument{"key was not passed to the map builder"};
+            }
+
+            if (occupied[position]) {
+                throw std::logic_error{"duplicate key"};
+            }
+            occupied[position] = true;
+
+            return data->items()[position];
+        }
+
+        template <typename Keys>
+        static hash_function build_hash_function(const Keys & keys)
+        {
+            // Finding pilots fails only if two keys have the same hash, which is very unlikely
+            // unless the keys are not unique.
+            constexpr std::uint64_t max_attempts{8};
+
+            hash_function result;
+            for (result.seed = 0; result.seed < max_attempts; ++result.seed) {
+                result.hashes.clear();
+                for (const auto & key : keys) {
+                    result.hashes.push_back(detail::hash_key(key, result.seed));
+                }
+
+                if (result.hashes.size() > std::numeric_limits<SizeType>::max()) {
+                    throw std::out_of_range{"too many keys for the size type"};
+                }
+
+                if (find_pilots(result.hashes, result.pilots)) {
+                    return result;
+                }
+            }
+
+            throw std::invalid_argument{"keys are not unique"};
+        }
+
+        static bool find_pilots(
+            const std::vector<std::uint64_t> & hashes, std::vector<std::uint32_t> & pilots)
+        {
+            const std::size_t n{hashes.size()};
+            const std::size_t bucket_count{(n + average_bucket_size - 1) / average_bucket_size};
+            pilots.assign(bucket_count, 0);
+
+            {
+                std::vector<std::uint64_t> sorted_hashes{hashes};
+                std::sort(sorted_hashes.begin(), sorted_hashes.end());
+                if (std::adjacent_find(sorted_hashes.begin(), sorted_hashes.end())
+                    != sorted_hashes.end()) {
+                    return false;
+                }
+            }
+
+            // Group the hashes by bucket
+            std::vector<std::size_t> bucket_start(bucket_count + 1, 0);
+            for (const auto hash : hashes) {
+                ++bucket_start[DataType::bucket(hash, bucket_count) + 1];
+            }
+            std::partial_sum(bucket_start.begin(), bucket_start.end(), bucket_start.begin());
+
+            std::vector<std::uint64_t> bucket_hashes(n);
+            {
+                std::vector<std::size_t> next{bucket_start.begin(), bucket_start.end() - 1};
+                for (const auto hash : hashes) {
+                    bucket_hashes[next[DataType::bucket(hash, bucket_count)]++] = hash;
+                }
+            }
+
+            const auto bucket_size = [&](std::size_t bucket) {
+                return bucket_start[bucket + 1] - bucket_start[bucket];
+            };
+
+            // Large buckets are placed first, while there are still many free positions
+            std::vector<std::size_t> bucket_order(bucket_count);
+            std::iota(bucket_order.begin(), bucket_order.end(), 0);
+            std::stable_sort(
+                bucket_order.begin(), bucket_order.end(),
+                [&](std::size_t a, std::size_t b) { return bucket_size(a) > bucket_size(b); });
+
+            std::vector<bool> taken(n);
+            std::vector<std::size_t> positions;
+
+            for (const auto bucket : bucket_order) {
+                if (bucket_size(bucket) == 0) {
+                    break;
+                }
+
+                const auto first{bucket_hashes.begin() + bucket_start[bucket]};
+                const auto last{bucket_hashes.begin() + bucket_start[bucket + 1]};
+
+                for (std::uint64_t pilot{0};; ++pilot) {
+                    if (pilot > std::numeric_limits<std::uint32_t>::max()) {
+                        return false;
+                    }
+
+                    positions.clear();
+                    for (auto it{first}; it != last; ++it) {
+                        const auto position{
+                            DataType::position(*it, static_cast<std::uint32_t>(pilot), n)};
+                        if (taken[position]
+                            or std::find(positions.begin(), positions.end(), position)
+                                   != positions.end()) {
+                            break;
+                        }
+                        positions.push_back(position);
+                    }
+
+                    if (positions.size() == bucket_size(bucket)) {
+                        for (const auto position : positions) {
+                            taken[position] = true;
+                        }
+                        pilots[bucket] = static_cast<std::uint32_t>(pilot);
+                        break;
+                    }
+                }
+            }
+
+            return true;
+        }
+    };
+
+    // Offsets of the key and value vectors of a generic_soa_map
+    template <typename Key, typename Value, typename SizeType>
+    struct soa_map_offset
+    {
+        builder_offset<detail::generic_vector_data<Key, SizeType>> keys;
+        builder_offset<detail::generic_vector_data<Value, SizeType>> values;
+    };
+
+    // Builds a generic_soa_map. The keys must be added in ascending order.
+    template <typename Key, typename Value, typename SizeType>
+    struct generic_soa_map_builder
+    {
+        builder_offset<detail::generic_vector_data<Key, SizeType>> keys;
+        builder_offset<detail::generic_vector_data<Value, SizeType>> values;
+        SizeType current_size{0};
+
+        soa_map_offset<Key, Value, SizeType> offset() const
+        {
+            return {keys, values};
+        }
+
+        builder_offset<Value> add_key(const Key & key)
+        {
+            if (current_size == keys->size()) {
+                throw std::out_of_range{"map is full"};
+            }
+
+            if (current_size > 0 and not((*keys)[current_size - 1] < key)) {
+                throw std::logic_error{"unsorted"};
+            }
+
+            (*keys)[current_size] = key;
+            return next_value();
+        }
+
+        template <typename Pointer>
+        builder_offset<Value> add_key(Pointer p)
+        {
+            if (current_size == keys->size()) {
+                throw std::out_of_range{"map is full"};
+            }
+
+            if (current_size > 0) {
+                const auto & last_key{(*keys)[current_size - 1]};
+                if (not(last_key < *p)) {
+                    throw std::logic_error{"unsorted"};
+                }
+            }
+
+            (*keys)[current_size] = p;
+            return next_value();
+        }
+
+    private:
+        builder_offset<Value> next_value()
+        {
+            auto result{values.b.convert_to_builder_offset(&(*values)[current_size])};
+            ++current_size;
+
+            return result;
+        }
+    };
+
+    // Offsets of the items and the search tree of a generic_s_tree_map
+    template <typename Key, typename Value, typename SizeType>
+    struct s_tree_map_offset
+    {
+        builder_offset<detail::generic_vector_data<std::pair<Key, Value>, SizeType>> items;
+        builder_offset<detail::generic_s_tree_data<Key, SizeType>> index;
+    };
+
+    // Builds a generic_s_tree_map. The keys must be added in ascending order.
+    template <typename Key, typename Value, typename SizeType>
+    struct generic_s_tree_map_builder
+    {
+        using ItemType = std::pair<Key, Value>;
+        using IndexDataType = detail::generic_s_tree_data<Key, SizeType>;
+
+        builder_offset<detail::generic_vector_data<ItemType, SizeType>> items;
+        builder_offset<IndexDataType> index;
+        SizeType current_size{0};
+
+        s_tree_map_offset<Key, Value, SizeType> offset() const
+        {
+            return {items, index};
+        }
+
+        builder_offset<Value> add_key(const Key & key)
+        {
+            if (current_size == items->size()) {
+                throw std::out_of_range{"map is full"};
+            }
+
+            if (current_size > 0 and not((*items)[current_size - 1].first < key)) {
+                throw std::logic_error{"unsorted"};
+            }
+
+            auto & item{(*items)[current_size]};
+            item.first = key;
+
+            Key * const keys{index->keys()};
+            IndexDataType::positions(
+                items->size(), current_size, [&](std::size_t position) { keys[position] = key; });
+
+            auto result{items.b.convert_to_builder_offset(&item.second)};
+            ++current_size;
+
+            return result;
+        }
+    };
+
+    // Result of builder::add_prefix_string(), which can be assigned to a generic_prefix_string
+    struct prefix_string_offset
+    {
+        static constexpr std::size_t inline_capacity{
+            detail::generic_prefix_string<std::int32_t>::inline_capacity};
+
+        std::uint32_t string_length;
+
+        // The first characters, padded with zeros
+        std::array<char, inline_capacity> chars;
+
+        // Only valid for strings which do not fit into the handle
+        builder_offset<detail::generic_string_data<std::uint32_t>> data;
+
+        std::string_view operator*() const
+        {
+            if (string_length <= inline_capacity) {
+                return {chars.data(), string_length};
+            }
+            return *data;
+        }
+    };
+
+    inline prefix_string_offset builder::add_prefix_string(std::string_view s)
+    {
+        if (s.size() > std::numeric_limits<std::uint32_t>::max()) {
+            throw std::out_of_range{"string is too long"};
+        }
+
+        prefix_string_offset result{
+            static_cast<std::uint32_t>(s.size()), {},
+            s.size() > prefix_string_offset::inline_capacity
+                ? add_string<std::uint32_t>(s)
+                : builder_offset<detail::generic_string_data<std::uint32_t>>{*this}};
+        std::memcpy(
+            result.chars.data(), s.data(),
+            std::min(s.size(), prefix_string_offset::inline_capacity));
+
+        return result;
+    }
+
+    template <typename OffsetType>
+    detail::generic_prefix_string<OffsetType> &
+    detail::generic_prefix_string<OffsetType>::operator=(const prefix_string_offset & s)
+    {
+        string_length = s.string_length;
+        std::memcpy(chars, s.chars.data(), inline_capacity);
+
+        if (not is_inline()) {
+            std::memset(chars + prefix_size, 0, inline_capacity - prefix_size);
+            s.data.assign_to(data());
+        }
+
+        return *this;
+    }
 }
@@ -0,0 +1,464 @@
+#pragma once
+
+#include "type-layout.h"
+#include "builder.h"
+#include "mapped-blob.h"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <numeric>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace pid {
+    // Order in which compact() stores the reachable objects of a blob
+    enum class layout_order
+    {
+        // The order of the source blob, i.e., usually the order of the builder calls
+        original,
+
+        // Each object is followed by the objects it points to, recursively
+        depth_first,
+
+        // The objects are stored level by level, starting at the root
+        breadth_first,
+
+        // Like depth_first, but the objects without pointers which an object points to are
+        // stored right after it, grouped by type, before any nested structures. For example,
+        // the string keys of a map follow its items, such that a lookup touches as few pages
+        // as possible.
+        leaves_first,
+    };
+
+    namespace detail {
+        // All objects and pointers which are reachable from a root object in a blob
+        struct object_graph final : layout_visitor
+        {
+            struct node
+            {
+                std::size_t offset;
+                std::size_t size;
+                const object_type * type;
+
+                // The pointers in the object are pointers[first_pointer, end_pointer)
+                std::size_t first_pointer;
+                std::size_t end_pointer;
+            };
+
+            // The offsets are relative to the start of the blob
+            struct pointer
+            {
+                std::size_t field;
+                std::size_t field_size;
+                std::size_t target;
+                const object_type * target_type;
+            };
+
+            std::span<const char> blob;
+            std::vector<node> nodes;
+            std::vector<pointer> pointers;
+
+            // Finds all reachable objects. The blob should have been verified if it comes from
+            // an untrusted source, only the bounds of the objects are checked here.
+            object_graph(
+                std::span<const char> blob, std::size_t root_offset, const object_type & root_type)
+                : blob{blob}
+            {
+                if (root_offset >= blob.size()) {
+                    throw std::invalid_argument{"root object is outside of the blob"};
+                }
+                stack.push_back({root_offset, &root_type});
+
+                while (not stack.empty()) {
+                    const auto [offset, type]{stack.back()};
+                    stack.pop_back();
+
+                    const char * const object{blob.data() + offset};
+                    if (reinterpret_cast<std::uintptr_t>(object) % type->alignment != 0) {
+                        throw std::invalid_argument{
+                            "object is not aligned at offset " + std::to_string(offset)};
+                    }
+
+                    if (not mark_visited(offset, *type)) {
+                        continue;
+                    }
+
+                    const std::size_t size{type->size(object, blob.size() - offset)};
+                    nodes.push_back({offset, size, type, pointers.size(), 0});
+                    type->visit(object, *this);
+                    nodes.back().end_pointer = pointers.size();
+                }
+            }
+
+            void edge(
+                const void * field, std::size_t field_size, std::int64_t offset,
+                const object_type & target_type) override
+            {
+                const auto field_offset{static_cast<std::int64_t>(
+                    static_cast<const char *>(field) - blob.data())};
+
+                std::int64_t target;
+                if (__builtin_add_overflow(field_offset, offset, &target) or target < 0
+                    or static_cast<std::uint64_t>(target) >= blob.size()) {
+                    throw std::invalid_argument{
+                        "pointer points outside of the blob at offset "
+                        + std::to_string(field_offset)};
+                }
+
+                pointers.push_back({
+                    static_cast<std::size_t>(field_offset), field_size,
+                    static_cast<std::size_t>(target), &target_type});
+                stack.push_back({static_cast<std::size_t>(target), &target_type});
+            }
+
+            void check(const void *, void (*)(const void *)) override {}
+
+        private:
+            struct task
+            {
+                std::size_t offset;
+                const object_type * type;
+            };
+
+            std::vector<task> stack;
+            std::vector<std::pair<const object_type *, std::vector<std::uint64_t>>> visited;
+
+            // Returns false if the object has been visited before
+            bool mark_visited(std::size_t offset, const object_type & type)
+            {
+                auto it{std::find_if(visited.begin(), visited.end(), [&](const auto & v) {
+                    return v.first == &type;
+                })};
+
+                if (it == visited.end()) {
+                    visited.emplace_back(
+                        &type, std::vector<std::uint64_t>(
+                                   bitmap_word_count(blob.size() / type.alignment + 1)));
+                    it = visited.end() - 1;
+                }
+
+                const std::size_t index{offset / type.alignment};
+                if (test_bit(it->second.data(), index)) {
+                    return false;
+                }
+                set_bit(it->second.data(), index);
+                return true;
+            }
+        };
+
+        // Contiguous range of the blob which is covered by reachable objects. Objects which
+        // overlap, e.g., because a pointer points into a vector, are moved together.
+        struct blob_region
+        {
+            std::size_t offset;
+            std::size_t size;
+
+            // Largest alignment of the objects in the region
+            std::size_t alignment;
+
+            // Largest placement of the objects in the region, see object_type::placement
+            std::size_t placement;
+
+            // Whether none of the objects contain pointers
+            bool is_leaf;
+
+            // Offset in the destination builder
+            std::size_t new_offset;
+        };
+
+        // Merges the objects of a graph into regions, which are sorted by their offsets
+        inline std::vector<blob_region> find_regions(const object_graph & graph)
+        {
+            std::vector<std::size_t> order(graph.nodes.size());
+            std::iota(order.begin(), order.end(), 0);
+            std::sort(order.begin(), order.end(), [&](std::size_t a, std::size_t b) {
+                return graph.nodes[a].offset < graph.nodes[b].offset;
+            });
+
+            std::vector<blob_region> result;
+            std::size_t end{0};
+            for (const std::size_t index : order) {
+                const auto & node{graph.nodes[index]};
+                const std::size_t alignment{node.type->alignment};
+                const std::size_t placement{node.type->placement};
+                const bool is_leaf{not node.type->has_pointers};
+
+                if (not result.empty() and node.offset < end) {
+                    auto & region{result.back()};
+                    end = std::max(end, node.offset + node.size);
+                    region.size = end - region.offset;
+                    region.alignment = std::max(region.alignment, alignment);
+                    region.placement = std::max(region.placement, placement);
+                    region.is_leaf = region.is_leaf and is_leaf;
+                } else {
+                    result.push_back({node.offset, node.size, alignment, placement, is_leaf, 0});
+                    end = node.offset + node.size;
+                }
+            }
+
+            return result;
+        }
+
+        // Returns the index of the region that contains 'offset'
+        inline std::size_t find_region(
+            const std::vector<blob_region> & regions, std::size_t offset)
+        {
+            const auto it{std::upper_bound(
+                regions.begin(), regions.end(), offset,
+                [](std::size_t offset, const blob_region & region) {
+                    return offset < region.offset;
+                })};
+            return static_cast<std::size_t>(it - regions.begin()) - 1;
+        }
+
+        // Returns the indices of the regions in the given order
+        inline std::vector<std::size_t> order_regions(
+            const object_graph & graph, const std::vector<blob_region> & regions,
+            std::size_t root_offset, layout_order order)
+        {
+            std::vector<std::size_t> result;
+
+            if (order == layout_order::original) {
+                result.resize(regions.size());
+                std::iota(result.begin(), result.end(), 0);
+                return result;
+            }
+            result.reserve(regions.size());
+
+            // The regions which each region points to, in the order of the pointer fields
+            struct region_edge
+            {
+                std::size_t source;
+                std::size_t field;
+                std::size_t target;
+                const object_type * target_type;
+            };
+
+            std::vector<region_edge> edges;
+            edges.reserve(graph.pointers.size());
+            for (const auto & p : graph.pointers) {
+                edges.push_back({
+                    find_region(regions, p.field), p.field, find_region(regions, p.target),
+                    p.target_type});
+            }
+            std::sort(edges.begin(), edges.end(), [](const auto & a, const auto & b) {
+                return a.source < b.source or (a.source == b.source and a.field < b.field);
+            });
+
+            std::vector<std::size_t> first_edge(regions.size() + 1, edges.size());
+            for (std::size_t i{edges.size()}; i-- > 0;) {
+                first_edge[edges[i].source] = i;
+            }
+            for (std::size_t index{regions.size()}; index-- > 0;) {
+                first_edge[index] = std::min(first_edge[index], first_edge[index + 1]);
+            }
+
+            std::vector<bool> placed(regions.size(), false);
+            const auto place{[&](std::size_t index) {
+                if (placed[index]) {
+                    return false;
+                }
+                placed[index] = true;
+                result.push_back(index);
+                return true;
+            }};
+
+            const std::size_t root{find_region(regions, root_offset)};
+
+            if (order == layout_order::breadth_first) {
+                place(root);
+                for (std::size_t next{0}; next < result.size(); ++next) {
+                    const std::size_t index{result[next]};
+                    for (std::size_t e{first_edge[index]}; e < first_edge[index + 1]; ++e) {
+                        place(edges[e].target);
+                    }
+                }
+                return result;
+            }
+
+            // Depth-first with an explicit stack, on which the children are pushed in reverse
+            // order such that they are visited in the order of their pointer fields
+            std::vector<std::size_t> stack{root};
+            while (not stack.empty()) {
+                const std::size_t index{stack.back()};
+                stack.pop_back();
+                if (not place(index)) {
+                    continue;
+                }
+
+                if (order == layout_order::leaves_first) {
+                    // Group the leaves by type, e.g., all keys of a map before its values
+                    for (std::size_t e{first_edge[index]}; e < first_edge[index + 1]; ++e) {
+                        const object_type * const type{edges[e].target_type};
+                        if (placed[edges[e].target] or not regions[edges[e].target].is_leaf) {
+                            continue;
+                        }
+                        for (std::size_t other{e}; other < first_edge[index + 1]; ++other) {
+                            if (edges[other].target_type == type
+                                and regions[edges[other].target].is_leaf) {
+                                place(edges[other].target);
+                            }
+                        }
+                    }
+                }
+
+                for (std::size_t e{first_edge[index + 1]}; e-- > first_edge[index];) {
+                    if (not placed[edges[e].target]) {
+                        stack.push_back(edges[e].target);
+                    }
+                }
+            }
+
+            return result;
+        }
+
+        // Copies the regions of a graph to the end of 'destination' in the given order and
+        // rewrites all pointers. Leaf regions with the same bytes are only copied once.
+        // Returns the new offset of 'root_offset'.
+        inline std::size_t write_regions(
+            const object_graph & graph, std::vector<blob_region> & regions,
+            std::span<const std::size_t> order, builder & destination, std::size_t root_offset)
+        {
+            const char * const source{graph.blob.data()};
+
+            // Assign the new offsets. The address of each region keeps its remainder modulo
+            // the alignment of the region, such that all objects in it stay aligned, and its
+            // offset keeps its remainder modulo the placement of the region.
+            std::unordered_multimap<std::uint64_t, std::size_t> leaves;
+            std::vector<bool> is_copy(regions.size(), false);
+            std::size_t end{destination.data.size()};
+
+            for (const std::size_t index : order) {
+                auto & region{regions[index]};
+                const auto source_address{
+                    reinterpret_cast<std::uintptr_t>(source) + region.offset};
+
+                if (region.is_leaf) {
+                    const std::uint64_t hash{hash_bytes(
+                        {source + region.offset, region.size},
+                        region.alignment ^ (source_address % region.alignment) << 32)};
+
+                    const auto [first, last]{leaves.equal_range(hash)};
+                    const auto duplicate{std::find_if(first, last, [&](const auto & entry) {
+                        const auto & other{regions[entry.second]};
+                        return other.size == region.size and other.alignment == region.alignment
+                               and other.placement == region.placement
+                               and (other.offset - region.offset) % region.placement == 0
+                               and std::memcmp(
+                                       source + other.offset, source + region.offset, region.size)
+                                       == 0;
+                    })};
+
+                    if (duplicate != last) {
+                        region.new_offset = regions[duplicate->second].new_offset;
+                        is_copy[index] = true;
+                        continue;
+                    }
+                    leaves.emplace(hash, index);
+                }
+
+                const auto end_address{
+                    reinterpret_cast<std::uintptr_t>(destination.data.at(end))};
+                std::size_t padding{
+                    (source_address % region.alignment + region.alignment
+                     - end_address % region.alignment)
+                    % region.alignment};
+                if (region.placement > region.alignment) {
+                    padding = (region.offset % region.placement + region.placement
+                               - end % region.placement)
+                              % region.placement;
+                    if ((end_address + padding) % region.alignment
+                        != source_address % region.alignment) {
+                        throw std::invalid_argument{
+                            "the destination is aligned differently from the blob"};
+                    }
+                }
+                region.new_offset = end + padding;
+                end = region.new_offset + region.size;
+            }
+
+            destination.data.resize(end);
+
+            for (std::size_t index{0}; index < regions.size(); ++index) {
+                const auto & region{regions[index]};
+                if (not is_copy[index]) {
+                    std::memcpy(
+                        destination.data.at(region.new_offset), source + region.offset,
+                        region.size);
+                }
+            }
+
+            const auto new_offset{[&](std::size_t offset) {
+                const auto & region{regions[find_region(regions, offset)]};
+                return region.new_offset + (offset - region.offset);
+            }};
+
+            for (const auto & p : graph.pointers) {
+                const std::size_t field{new_offset(p.field)};
+                const auto offset{static_cast<std::int64_t>(new_offset(p.target) - field)};
+
+                // Pointers in leaf regions do not exist, so each field is written only once
+                const auto fits{[&](auto value) {
+                    using OffsetType = decltype(value);
+                    if (offset < std::numeric_limits<OffsetType>::min()
+                        or offset > std::numeric_limits<OffsetType>::max()) {
+                        throw pointer_too_far{};
+                    }
+                    const auto narrow{static_cast<OffsetType>(offset)};
+                    std::memcpy(destination.data.at(field), &narrow, sizeof(narrow));
+                }};
+
+                switch (p.field_size) {
+                    case 1: fits(std::int8_t{}); break;
+                    case 2: fits(std::int16_t{}); break;
+                    case 4: fits(std::int32_t{}); break;
+                    default: fits(std::int64_t{}); break;
+                }
+            }
+
+            return new_offset(root_offset);
+        }
+    }
+
+    // Copies the objects which are reachable from the object of type Root at 'root_offset' to
+    // the end of 'destination', and returns the new root. Unreachable bytes are dropped,
+    // objects without pointers which have the same bytes (e.g., equal strings) are stored
+    // once, and all pointers are recomputed. The objects are stored in the given order, see
+    // layout_order.
+    //
+    // Throws pid::pointer_too_far if a pointer does not fit into its offset type in the new
+    // layout. With layout_order::original, this can only happen if duplicates are far away
+    // from each other.
+    template <typename Root>
+    builder_offset<Root> compact(
+        std::span<const char> blob, std::size_t root_offset, builder & destination,
+        layout_order order = layout_order::original)
+    {
+        const detail::object_graph graph{blob, root_offset, object_type_of<Root>};
+        auto regions{detail::find_regions(graph)};
+        const auto region_order{detail::order_regions(graph, regions, root_offset, order)};
+
+        return {
+            destination,
+            detail::write_regions(graph, regions, region_order, destination, root_offset)};
+    }
+
+    // Like compact(), but for blobs with a header, see mapped-blob.h. The destination must be
+    // empty, and the result is a complete blob with a header.
+    template <typename Root>
+    void compact_blob(
+        std::span<const char> blob, builder & destination,
+        layout_order order = layout_order::original)
+    {
+        const Root & root{open_blob<Root>(blob)};
+        const auto root_offset{
+            static_cast<std::size_t>(reinterpret_cast<const char *>(&root) - blob.data())};
+
+        auto header{add_blob_header(destination)};
+        finish_blob(header, compact<Root>(blob, root_offset, destination, order));
+    }
+}
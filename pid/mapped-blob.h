@@ -0,0 +1,237 @@
+#pragma once
+
+#include "pid.h"
+#include "builder.h"
+
+#include <array>
+#include <cerrno>
+#include <span>
+#include <string>
+#include <system_error>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace pid {
+    // Fixed-size header at the start of a blob that is meant to be stored in a file.
+    //
+    // All fields are stored in the native byte order of the machine that built the blob.
+    struct blob_header
+    {
+        static constexpr std::array<char, 8> expected_magic{'P', 'I', 'D', 'B', 'L', 'O', 'B', 0};
+        static constexpr std::uint32_t current_format_version{1};
+
+        std::array<char, 8> magic;
+        std::uint32_t format_version;
+        std::uint32_t header_size;
+        std::uint64_t root_offset;
+        std::uint64_t blob_size;
+        std::uint64_t type_fingerprint;
+    };
+
+    namespace detail {
+        constexpr std::uint64_t fnv1a(std::string_view s, std::uint64_t hash = 0xcbf29ce484222325)
+        {
+            for (const char c : s) {
+                hash = (hash ^ static_cast<unsigned char>(c)) * 0x100000001b3;
+            }
+            return hash;
+        }
+
+        // Identifies the root type of a blob. It is derived from the name of the type as it is
+        // spelled by the compiler, and from its size and alignment. It is only meant to catch
+        // mistakes like opening a blob with the wrong root type, and it is not guaranteed to be
+        // stable across compilers.
+        template <typename T>
+        constexpr std::uint64_t type_fingerprint()
+        {
+            const std::uint64_t name_hash{fnv1a(__PRETTY_FUNCTION__)};
+            return (name_hash ^ (sizeof(T) << 8) ^ alignof(T)) * 0x100000001b3;
+        }
+    }
+
+    // Adds a blob header to an empty builder. The header must be completed with finish_blob()
+    // once the root object has been built.
+    inline builder_offset<blob_header> add_blob_header(builder & b)
+    {
+        if (not b.data.empty()) {
+            throw std::logic_error{"blob header must be the first object in the builder"};
+        }
+
+        auto header{b.add<blob_header>()};
+        header->magic = blob_header::expected_magic;
+        header->format_version = blob_header::current_format_version;
+        header->header_size = sizeof(blob_header);
+
+        return header;
+    }
+
+    // Stores the root offset, the blob size and the type fingerprint in the header. This must
+    // be called after all data have been added to the builder. If the header has been flushed
+    // to a streamed file already, it is overwritten in the file.
+    template <typename Root>
+    void finish_blob(builder_offset<blob_header> header, const builder_offset<Root> & root)
+    {
+        if (&header.b != &root.b) {
+            throw std::invalid_argument{"root does not belong to the builder of the header"};
+        }
+
+        if (not root) {
+            throw std::invalid_argument{"blob must have a root object"};
+        }
+
+        // The header cannot be read if it has been flushed, so all fields are written
+        const blob_header value{
+            blob_header::expected_magic, blob_header::current_format_version, sizeof(blob_header),
+            root.offset, header.b.data.size(), detail::type_fingerprint<Root>()};
+        header.b.data.write(header.offset, &value, sizeof(value));
+    }
+
+    // Validates the header of a blob and returns a reference to its root object. The data are
+    // not copied, so the blob must outlive the returned reference.
+    template <typename Root>
+    const Root & open_blob(std::span<const char> blob)
+    {
+        if (blob.size() < sizeof(blob_header)) {
+            throw std::invalid_argument{"blob is too small to contain a header"};
+        }
+
+        if (reinterpret_cast<std::uintptr_t>(blob.data()) % alignof(blob_header) != 0) {
+            throw std::invalid_argument{"blob is not aligned"};
+        }
+
+        const auto & header{*reinterpret_cast<const blob_header *>(blob.data())};
+
+        if (header.magic != blob_header::expected_magic) {
+            throw std::invalid_argument{"blob has no valid header"};
+        }
+
+        if (header.format_version != blob_header::current_format_version
+            or header.header_size != sizeof(blob_header)) {
+            throw std::invalid_argument{"unsupported blob format version"};
+        }
+
+        if (header.blob_size != blob.size()) {
+            throw std::invalid_argument{"blob size does not match the header"};
+        }
+
+        if (header.type_fingerprint != detail::type_fingerprint<Root>()) {
+            throw std::invalid_argument{"blob has a different root type"};
+        }
+
+        if (header.root_offset < sizeof(blob_header)
+            or sizeof(Root) > blob.size() or header.root_offset > blob.size() - sizeof(Root)
+            or (reinterpret_cast<std::uintptr_t>(blob.data()) + header.root_offset) % alignof(Root)
+                   != 0) {
+            throw std::invalid_argument{"blob has an invalid root offset"};
+        }
+
+        return *reinterpret_cast<const Root *>(blob.data() + header.root_offset);
+    }
+
+    // Maps a blob file read-only into memory. Opening the file only reads the header, and the
+    // remaining pages are loaded lazily by the kernel when they are accessed.
+    template <typename Root>
+    struct mapped_blob
+    {
+        explicit mapped_blob(const std::string & path)
+        {
+            const int fd{::open(path.c_str(), O_RDONLY | O_CLOEXEC)};
+            if (fd < 0) {
+                throw std::system_error{errno, std::generic_category(), "Cannot open " + path};
+            }
+
+            struct stat file_status;
+            if (::fstat(fd, &file_status) != 0) {
+                const int error{errno};
+                ::close(fd);
+                throw std::system_error{error, std::generic_category(), "Cannot stat " + path};
+            }
+
+            length = static_cast<std::size_t>(file_status.st_size);
+            if (length < sizeof(blob_header)) {
+                ::close(fd);
+                throw std::invalid_argument{"blob is too small to contain a header"};
+            }
+
+            void * p{::mmap(nullptr, length, PROT_READ, MAP_SHARED, fd, 0)};
+            const int error{errno};
+            ::close(fd);
+
+            if (p == MAP_FAILED) {
+                throw std::system_error{error, std::generic_category(), "Cannot map " + path};
+            }
+            start = static_cast<const char *>(p);
+
+            try {
+                root_object = &open_blob<Root>(data());
+            } catch (...) {
+                ::munmap(const_cast<char *>(start), length);
+                throw;
+            }
+        }
+
+        mapped_blob(const mapped_blob &) = delete;
+
+        mapped_blob(mapped_blob && other) noexcept
+            : start{std::exchange(other.start, nullptr)},
+              length{std::exchange(other.length, 0)},
+              root_object{std::exchange(other.root_object, nullptr)}
+        {
+        }
+
+        mapped_blob & operator=(const mapped_blob &) = delete;
+
+        mapped_blob & operator=(mapped_blob && other) noexcept
+        {
+            if (this != &other) {
+                unmap();
+                start = std::exchange(other.start, nullptr);
+                length = std::exchange(other.length, 0);
+                root_object = std::exchange(other.root_object, nullptr);
+            }
+            return *this;
+        }
+
+        ~mapped_blob()
+        {
+            unmap();
+        }
+
+        std::span<const char> data() const
+        {
+            return {start, length};
+        }
+
+        const Root & root() const
+        {
+            return *root_object;
+        }
+
+        const Root & operator*() const
+        {
+            return *root_object;
+        }
+
+        const Root * operator->() const
+        {
+            return root_object;
+        }
+
+    private:
+        const char * start{nullptr};
+        std::size_t length{0};
+        const Root * root_object{nullptr};
+
+        void unmap() noexcept
+        {
+            if (start != nullptr) {
+                ::munmap(const_cast<char *>(start), length);
+                start = nullptr;
+            }
+        }
+    };
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include "compact.h"
+
+#include <cstdint>
+#include <span>
+#include <tuple>
+#include <type_traits>
+
+namespace pid {
+    // The offset types of pid8, pid16, pid32 and pid64, from the narrowest to the widest
+    using offset_types = std::tuple<std::int8_t, std::int16_t, std::int32_t, std::int64_t>;
+
+    // Returns the size in bytes of the narrowest offset type which can store the distance of
+    // every pointer that is reachable from the object of type Root at 'root_offset', i.e.,
+    // 1, 2, 4 or 8. Returns 1 if there are no pointers.
+    //
+    // For a blob that has been built with wide offsets, this tells which offset type would be
+    // sufficient. Blobs with narrower offsets are smaller, so the distances can only shrink,
+    // except for padding for the alignment of the objects.
+    template <typename Root>
+    std::size_t required_offset_size(std::span<const char> blob, std::size_t root_offset)
+    {
+        const detail::object_graph graph{blob, root_offset, object_type_of<Root>};
+
+        std::size_t result{1};
+        for (const auto & p : graph.pointers) {
+            const auto offset{
+                static_cast<std::int64_t>(p.target) - static_cast<std::int64_t>(p.field)};
+
+            while (result < sizeof(std::int64_t)) {
+                const std::int64_t limit{std::int64_t{1} << (8 * result - 1)};
+                if (offset >= -limit and offset < limit) {
+                    break;
+                }
+                result *= 2;
+            }
+        }
+
+        return result;
+    }
+
+    // Builds data with the narrowest offset type for which all pointers fit. The data
+    // structures must be templates over their offset type, and build(b, offset_type) must add
+    // them to the builder, where 'offset_type' is a std::type_identity of std::int8_t,
+    // std::int16_t, std::int32_t and std::int64_t, in this order, until no
+    // pid::pointer_too_far is thrown. The data which a failed attempt has added are removed
+    // again. Returns the size of the offset type that has been used.
+    //
+    // Each failed attempt stops at the first pointer which does not fit. If the required
+    // offset type can be estimated, e.g., with required_offset_size() for a similar blob,
+    // 'minimum_size' skips the narrower ones.
+    template <typename Build>
+    std::size_t build_with_narrowest_offsets(
+        builder & b, Build build, std::size_t minimum_size = 1)
+    {
+        const std::size_t start{b.data.size()};
+
+        return std::apply(
+            [&](auto... offset_types) {
+                std::size_t result{0};
+                const auto attempt{[&](auto offset_type) {
+                    using OffsetType = decltype(offset_type);
+                    if (result != 0 or sizeof(OffsetType) < minimum_size) {
+                        return;
+                    }
+
+                    try {
+                        build(b, std::type_identity<OffsetType>{});
+                        result = sizeof(OffsetType);
+                    } catch (const pointer_too_far &) {
+                        if constexpr (std::is_same_v<OffsetType, std::int64_t>) {
+                            throw;
+                        }
+                        b.data.resize(start);
+                    }
+                }};
+
+                (attempt(offset_types), ...);
+                return result;
+            },
+            offset_types{});
+    }
+}
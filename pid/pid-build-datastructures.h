@@ -2,12 +2,16 @@
 
 #include "pid.h"
 #include "builder.h"
+#include "type-layout.h"
 
 #include <iostream>
 #include <map>
 #include <optional>
-#include <any>
+#include <cstring>
+#include <deque>
 #include <atomic>
+#include <ranges>
+#include <utility>
 
 namespace pid {
     template <typename T>
@@ -70,10 +74,456 @@ namespace pid {
     {
     };
 
+    // Tags which select the layout of maps that are built by datastructure_builder
+    struct sorted_map_layout
+    {
+        template <typename Key, typename Value>
+        using map_type = pid32::map32<Key, Value>;
+    };
+
+    struct eytzinger_map_layout
+    {
+        template <typename Key, typename Value>
+        using map_type = pid32::eytzinger_map32<Key, Value>;
+    };
+
+    struct hash_map_layout
+    {
+        template <typename Key, typename Value>
+        using map_type = pid32::hash_map32<Key, Value>;
+    };
+
+    struct soa_map_layout
+    {
+        template <typename Key, typename Value>
+        using map_type = pid32::soa_map32<Key, Value>;
+    };
+
+    // Only for integer keys
+    struct s_tree_map_layout
+    {
+        template <typename Key, typename Value>
+        using map_type = pid32::s_tree_map32<Key, Value>;
+    };
+
+    template <typename T>
+    struct validity_bitmap_vector_type
+    {
+        static_assert(std::is_arithmetic<T>::value || std::is_enum<T>::value);
+        using type = pid32::optional_vector32<T>;
+    };
+
+    template <>
+    struct validity_bitmap_vector_type<std::string>
+    {
+        using type = pid32::optional_string_vector32;
+    };
+
+    // Tag which selects a validity bitmap for vectors of optional values, instead of a vector
+    // of std::optional<T> or pointers. Nested vectors are built with it if they are wrapped in
+    // with_layout.
+    struct validity_bitmap_layout
+    {
+        template <typename T>
+        using vector_type = typename validity_bitmap_vector_type<T>::type;
+    };
+
+    // Tag which selects contiguous storage for vectors of strings, instead of a vector of
+    // separately allocated strings
+    struct string_vector_layout
+    {
+        template <typename T>
+        using vector_type = pid32::string_vector32;
+    };
+
+    // Tag which selects a vector of strings that are compressed with a shared symbol table,
+    // see detail::generic_compressed_string_vector_data
+    struct compressed_string_vector_layout
+    {
+        template <typename T>
+        using vector_type = pid32::compressed_string_vector32;
+    };
+
+    // Input value which is built with the given layout tag wherever it is nested, e.g., the
+    // values of a
+    //
+    //     std::map<std::string, pid::with_layout<
+    //         std::vector<std::optional<std::int32_t>>, pid::validity_bitmap_layout>>
+    //
+    // are stored as pid32::optional_vector32<std::int32_t>. Only vectors are supported.
+    template <typename T, typename Layout>
+    struct with_layout : T
+    {
+        using T::T;
+
+        with_layout(T value) : T{std::move(value)} {}
+    };
+
+    template <typename T, typename Layout>
+    struct pid_base_type<with_layout<std::vector<T>, Layout>>
+    {
+        using type = typename Layout::template vector_type<typename T::value_type>;
+    };
+
+    namespace detail {
+        // Open-addressing hash table which maps the hashes of values to the offsets where the
+        // values are stored in the builder data. The values themselves are not copied: if the
+        // hash of an entry matches, the caller compares its value with the data at the offset.
+        struct offset_cache
+        {
+            // 'offset' is stored plus one, such that zero marks empty slots
+            struct entry
+            {
+                std::uint64_t hash;
+                std::size_t offset;
+            };
+
+            std::vector<entry> entries;
+            std::size_t count{0};
+
+            // Returns the offset of an existing value with the given hash for which
+            // matches(offset) is true, or the offset that add() returns for a new value.
+            template <typename Matches, typename Add>
+            std::size_t find_or_add(std::uint64_t hash, Matches matches, Add add)
+            {
+                if (const auto found{find(hash, matches)}) {
+                    return *found;
+                }
+
+                // add() may use other caches, but not this one, so the table does not change
+                // in the meantime
+                const std::size_t offset{add()};
+                insert(hash, offset);
+                return offset;
+            }
+
+            template <typename Matches>
+            std::optional<std::size_t> find(std::uint64_t hash, Matches matches) const
+            {
+                if (entries.empty()) {
+                    return std::nullopt;
+                }
+
+                const std::size_t mask{entries.size() - 1};
+                for (std::size_t i{hash & mask}; entries[i].offset != 0; i = (i + 1) & mask) {
+                    if (entries[i].hash == hash and matches(entries[i].offset - 1)) {
+                        return entries[i].offset - 1;
+                    }
+                }
+
+                return std::nullopt;
+            }
+
+            void insert(std::uint64_t hash, std::size_t offset)
+            {
+                // Keep the load factor below 1/2, such that probe sequences stay short
+                if (2 * (count + 1) > entries.size()) {
+                    std::vector<entry> old_entries(std::max<std::size_t>(16, 2 * entries.size()));
+                    std::swap(entries, old_entries);
+                    count = 0;
+                    for (const auto & e : old_entries) {
+                        if (e.offset != 0) {
+                            insert(e.hash, e.offset - 1);
+                        }
+                    }
+                }
+
+                const std::size_t mask{entries.size() - 1};
+                std::size_t i{hash & mask};
+                while (entries[i].offset != 0) {
+                    i = (i + 1) & mask;
+                }
+                entries[i] = {hash, offset + 1};
+                ++count;
+            }
+        };
+
+        // Hashes of the input values of datastructure_builder, which are consistent with
+        // stored_value_matches(). Numbers are compared bitwise.
+        template <typename T>
+        std::uint64_t input_hash(const std::optional<T> & value);
+
+        template <typename T>
+        std::uint64_t input_hash(const std::vector<T> & value);
+
+        template <typename Key, typename Value>
+        std::uint64_t input_hash(const std::map<Key, Value> & value);
+
+        template <typename T, typename Layout>
+        std::uint64_t input_hash(const with_layout<T, Layout> & value);
+
+        template <typename T>
+            requires(std::is_arithmetic_v<T> or std::is_enum_v<T>)
+        std::uint64_t input_hash(const T & value)
+        {
+            std::uint64_t bits{0};
+            std::memcpy(&bits, &value, sizeof(T));
+            return mix_hash(bits);
+        }
+
+        inline std::uint64_t input_hash(const std::string & value)
+        {
+            return hash_bytes(value, 0);
+        }
+
+        template <typename T>
+        std::uint64_t input_hash(const std::optional<T> & value)
+        {
+            return value ? mix_hash(input_hash(*value) + 1) : 0;
+        }
+
+        // Whether the items of a std::vector<T> can be hashed and compared bytewise.
+        // std::vector<bool> has no data().
+        template <typename T>
+        constexpr bool contiguous_numbers{
+            (std::is_arithmetic_v<T> or std::is_enum_v<T>) and not std::is_same_v<T, bool>};
+
+        template <typename T>
+        std::uint64_t input_hash(const std::vector<T> & value)
+        {
+            if constexpr (contiguous_numbers<T>) {
+                return hash_bytes(
+                    {reinterpret_cast<const char *>(value.data()), value.size() * sizeof(T)}, 1);
+            } else {
+                std::uint64_t result{mix_hash(value.size())};
+                for (const auto & item : value) {
+                    result = mix_hash(result ^ input_hash(item));
+                }
+                return result;
+            }
+        }
+
+        template <typename Key, typename Value>
+        std::uint64_t input_hash(const std::map<Key, Value> & value)
+        {
+            std::uint64_t result{mix_hash(value.size() + 2)};
+            for (const auto & [key, mapped] : value) {
+                result = mix_hash(result ^ input_hash(key));
+                result = mix_hash(result ^ input_hash(mapped));
+            }
+            return result;
+        }
+
+        template <typename T, typename Layout>
+        std::uint64_t input_hash(const with_layout<T, Layout> & value)
+        {
+            return input_hash(static_cast<const T &>(value));
+        }
+
+        // Compares a value which has been stored by datastructure_builder with an input value
+        template <typename T>
+            requires(std::is_arithmetic_v<T> or std::is_enum_v<T>)
+        bool stored_value_matches(const T & stored, const T & value)
+        {
+            return std::memcmp(&stored, &value, sizeof(T)) == 0;
+        }
+
+        template <typename T>
+            requires(std::is_arithmetic_v<T> or std::is_enum_v<T>)
+        bool stored_value_matches(const std::optional<T> & stored, const std::optional<T> & value)
+        {
+            return stored.has_value() == value.has_value()
+                   and (not stored or stored_value_matches(*stored, *value));
+        }
+
+        template <typename OffsetType, typename SizeType>
+        bool stored_value_matches(
+            const generic_string<OffsetType, SizeType> & stored, const std::string & value)
+        {
+            return std::string_view{stored} == value;
+        }
+
+        template <typename T, typename OffsetType, typename Value>
+        bool stored_value_matches(
+            const ptr<T, OffsetType> & stored, const std::optional<Value> & value)
+        {
+            return bool(stored) == value.has_value()
+                   and (not stored or stored_value_matches(*stored, *value));
+        }
+
+        template <typename T, typename Value>
+        bool stored_items_match(const T * stored, const std::vector<Value> & value)
+        {
+            if constexpr (contiguous_numbers<Value>) {
+                return std::memcmp(stored, value.data(), value.size() * sizeof(Value)) == 0;
+            } else {
+                return std::equal(
+                    value.begin(), value.end(), stored,
+                    [](const auto & v, const auto & s) { return stored_value_matches(s, v); });
+            }
+        }
+
+        template <typename T, typename SizeType, typename Value>
+        bool stored_value_matches(
+            const generic_vector_data<T, SizeType> & stored, const std::vector<Value> & value)
+        {
+            return stored.size() == value.size() and stored_items_match(stored.begin(), value);
+        }
+
+        template <typename T, typename OffsetType, typename SizeType, typename Value>
+        bool stored_value_matches(
+            const generic_vector<T, OffsetType, SizeType> & stored,
+            const std::vector<Value> & value)
+        {
+            return stored.size() == value.size() and stored_items_match(stored.begin(), value);
+        }
+
+        template <
+            typename Key, typename Value, typename OffsetType, typename SizeType,
+            typename InputKey, typename InputValue>
+        bool stored_value_matches(
+            const generic_map<Key, Value, OffsetType, SizeType> & stored,
+            const std::map<InputKey, InputValue> & value)
+        {
+            return stored.size() == value.size()
+                   and std::equal(
+                       value.begin(), value.end(), stored.begin(),
+                       [](const auto & v, const auto & s) {
+                           return stored_value_matches(s.first, v.first)
+                                  and stored_value_matches(s.second, v.second);
+                       });
+        }
+
+        // Compares an item of a vector which has been built with a layout tag, e.g., a
+        // std::optional<std::string_view> of a pid32::optional_string_vector32
+        template <typename Stored>
+        bool layout_item_matches(const Stored & stored, const std::string & value)
+        {
+            return std::string_view{stored} == value;
+        }
+
+        template <typename T>
+            requires(std::is_arithmetic_v<T> or std::is_enum_v<T>)
+        bool layout_item_matches(const T & stored, const T & value)
+        {
+            return stored_value_matches(stored, value);
+        }
+
+        template <typename Stored, typename Value>
+        bool layout_item_matches(const Stored & stored, const std::optional<Value> & value)
+        {
+            return stored.has_value() == value.has_value()
+                   and (not value or layout_item_matches(*stored, *value));
+        }
+
+        template <typename Stored, typename T, typename Layout>
+        bool stored_value_matches(
+            const Stored & stored, const with_layout<std::vector<T>, Layout> & value)
+        {
+            return stored.size() == value.size()
+                   and std::equal(
+                       value.begin(), value.end(), stored.begin(),
+                       [](const auto & v, const auto & s) { return layout_item_matches(s, v); });
+        }
+    }
+
+    namespace detail {
+        // Hashes a serialized object without the values of its pointers, but with the
+        // offsets of their targets in the builder data. Objects with equal hashes may be
+        // interchangeable, which is then checked with serialized_comparer.
+        struct serialized_hasher final : layout_visitor
+        {
+            serialized_hasher(const char * data_start, const char * object)
+                : data_start{data_start}, object{object}
+            {
+            }
+
+            const char * data_start;
+            const char * object;
+            std::size_t position{0};
+            std::uint64_t result{0};
+
+            std::uint64_t hash(const object_type & type, std::size_t size)
+            {
+                type.visit(object, *this);
+                return hash_bytes({object + position, size - position}, result);
+            }
+
+            void edge(
+                const void * field, std::size_t field_size, std::int64_t offset,
+                const object_type &) override
+            {
+                const auto field_pointer{static_cast<const char *>(field)};
+                const auto field_position{static_cast<std::size_t>(field_pointer - object)};
+                const auto target{static_cast<std::size_t>(field_pointer - data_start + offset)};
+
+                result = hash_bytes({object + position, field_position - position}, result);
+                result = mix_hash(result ^ target);
+                position = field_position + field_size;
+            }
+
+            void check(const void *, void (*)(const void *)) override {}
+        };
+
+        // Checks if two serialized objects of the same type are interchangeable, i.e., they
+        // have the same bytes, except for their pointers, which point to the same objects.
+        // The pointers are found in the first object. At the same positions, the other object
+        // must have pointers as well, because the bytes which determine the layout are equal.
+        struct serialized_comparer final : layout_visitor
+        {
+            serialized_comparer(const char * object, const char * other)
+                : object{object}, other{other}
+            {
+            }
+
+            const char * object;
+            const char * other;
+            std::size_t position{0};
+            bool equal{true};
+
+            bool compare(const object_type & type, std::size_t size)
+            {
+                type.visit(object, *this);
+                return equal
+                       and std::memcmp(object + position, other + position, size - position) == 0;
+            }
+
+            void edge(
+                const void * field, std::size_t field_size, std::int64_t offset,
+                const object_type &) override
+            {
+                const auto field_position{
+                    static_cast<std::size_t>(static_cast<const char *>(field) - object)};
+
+                const std::int64_t other_offset{read_offset(other + field_position, field_size)};
+
+                equal = equal
+                        and std::memcmp(
+                                object + position, other + position, field_position - position)
+                                == 0
+                        and (offset == 0) == (other_offset == 0)
+                        and object + offset == other + other_offset;
+                position = field_position + field_size;
+            }
+
+            void check(const void *, void (*)(const void *)) override {}
+
+            static std::int64_t read_offset(const char * field, std::size_t field_size)
+            {
+                switch (field_size) {
+                    case 1: return *reinterpret_cast<const std::int8_t *>(field);
+                    case 2: return *reinterpret_cast<const std::int16_t *>(field);
+                    case 4: return *reinterpret_cast<const std::int32_t *>(field);
+                    default: return *reinterpret_cast<const std::int64_t *>(field);
+                }
+            }
+        };
+
+        // Tag for the caches of datastructure_builder::deduplicate()
+        template <typename DataType>
+        struct serialized;
+    }
+
     struct datastructure_builder
     {
         pid::builder & b;
-        std::map<std::size_t, std::any> caches{};
+
+        // One cache for each type of input value. A deque keeps the caches in place while
+        // more are added.
+        std::deque<detail::offset_cache> caches{};
+
+        // flushed_size() of the builder data when the caches were last emptied
+        std::size_t cached_flushed_size{0};
 
         static std::size_t next_cache_index()
         {
@@ -89,19 +539,67 @@ namespace pid {
         }
 
         template <typename T>
-        using CacheType = std::map<
-            T, decltype(std::declval<datastructure_builder>()(std::declval<T>())), std::less<>>;
-
-        template <typename T>
-        CacheType<T> & get_cache()
+        detail::offset_cache & get_cache()
         {
+            // The cached values are compared with new values, so neither they nor their
+            // children may have been flushed. Since the children can be anywhere before their
+            // parents, all entries are evicted.
+            if (b.data.flushed_size() != cached_flushed_size) {
+                for (auto & cache : caches) {
+                    cache = {};
+                }
+                cached_flushed_size = b.data.flushed_size();
+            }
+
             const auto index{cache_index<T>()};
-            auto it{caches.find(index)};
-            if (it == caches.end()) {
-                it = caches.insert(std::make_pair(index, CacheType<T>{})).first;
+            if (index >= caches.size()) {
+                caches.resize(index + 1);
             }
 
-            return std::any_cast<CacheType<T> &>(it->second);
+            return caches[index];
+        }
+
+        // Returns the offset of an object that has been built before and is identical to the
+        // object at 'offset', i.e., it has the same bytes and its pointers point to the same
+        // objects. Otherwise, the object is remembered and std::nullopt is returned.
+        template <typename DataType>
+        std::optional<std::size_t> find_duplicate(std::size_t offset)
+        {
+            const object_type & type{object_type_of<DataType>};
+            auto & cache{get_cache<detail::serialized<DataType>>()};
+
+            // The targets of pointers are hashed relative to the start of the window of
+            // streamed storage, which is fine because the caches are evicted after a flush
+            const char * const object{b.data.at(offset)};
+            const std::size_t size{type.size(object, b.data.size() - offset)};
+
+            const std::uint64_t hash{
+                detail::serialized_hasher{b.data.data(), object}.hash(type, size)};
+
+            const auto found{cache.find(hash, [&](std::size_t candidate) {
+                return type.size(b.data.at(candidate), b.data.size() - candidate) == size
+                       and detail::serialized_comparer{object, b.data.at(candidate)}.compare(
+                           type, size);
+            })};
+
+            if (not found) {
+                cache.insert(hash, offset);
+            }
+            return found;
+        }
+
+        // Replaces an object by an identical object that has been built before. 'start' is the
+        // size of the builder data before the object and its children were added. The objects
+        // behind 'start' are only referenced by the new object, so they are removed if it is
+        // a duplicate.
+        template <typename DataType>
+        builder_offset<DataType> deduplicate(builder_offset<DataType> object, std::size_t start)
+        {
+            if (const auto found{find_duplicate<DataType>(object.offset)}) {
+                b.data.resize(start);
+                return {b, *found};
+            }
+            return object;
         }
 
         template <
@@ -115,38 +613,34 @@ namespace pid {
         inline builder_offset<detail::generic_string_data<std::uint32_t>> operator()(
             const std::string & s)
         {
-            auto & cache{get_cache<std::string>()};
-            auto it{cache.find(s)};
-            if (it == cache.end()) {
-                it = cache.insert(std::make_pair(s, b.add_string(s))).first;
-            }
-            return it->second;
+            using DataType = detail::generic_string_data<std::uint32_t>;
+
+            const std::size_t offset{get_cache<std::string>().find_or_add(
+                detail::input_hash(s),
+                [&](std::size_t offset) {
+                    return std::string_view{*builder_offset<DataType>{b, offset}} == s;
+                },
+                [&] { return b.add_string(s).offset; })};
+
+            return {b, offset};
         }
 
         template <typename T>
         auto operator()(const std::optional<T> & o)
         {
+            using HandleType = typename pid_base_type<T>::type;
+
             if constexpr (std::is_arithmetic<T>::value || std::is_enum<T>::value) {
                 return o;
-            } else {
-                if (o) {
-                    return (*this)(*o);
-                } else {
-                    return builder_offset<typename pid_base_type<T>::type>{b};
-                }
-            }
-        }
-
-        auto operator()(const std::optional<std::string> & o)
-        {
-            // TODO: we could also try to store this as an std::optional<pid::string32>
-            if (o) {
-                const builder_offset<detail::generic_string_data<std::uint32_t>> data{(*this)(*o)};
-                builder_offset<pid32::string32> result{b.add<pid32::string32>()};
+            } else if (o) {
+                // TODO: we could also try to store this as an std::optional<HandleType>
+                const std::size_t start{b.data.size()};
+                const auto data{(*this)(*o)};
+                builder_offset<HandleType> result{b.add<HandleType>()};
                 *result = data;
-                return result;
+                return deduplicate(result, start);
             } else {
-                return builder_offset<pid32::string32>{b};
+                return builder_offset<HandleType>{b};
             }
         }
 
@@ -155,12 +649,46 @@ namespace pid {
             detail::generic_vector_data<typename pid_type<T>::type, std::uint32_t>>
         operator()(const std::vector<T> & v)
         {
-            auto & cache{get_cache<std::vector<T>>()};
-            auto it{cache.find(v)};
-            if (it == cache.end()) {
-                it = cache.insert(std::make_pair(v, build(v))).first;
+            using DataType =
+                detail::generic_vector_data<typename pid_type<T>::type, std::uint32_t>;
+
+            const std::size_t offset{get_cache<std::vector<T>>().find_or_add(
+                detail::input_hash(v),
+                [&](std::size_t offset) {
+                    return detail::stored_value_matches(*builder_offset<DataType>{b, offset}, v);
+                },
+                [&] { return build(v).offset; })};
+
+            return {b, offset};
+        }
+
+        auto operator()(const std::vector<std::string> & v, string_vector_layout)
+        {
+            const std::size_t start{b.data.size()};
+            return deduplicate(b.add_string_vector<std::uint32_t>(v), start);
+        }
+
+        auto operator()(const std::vector<std::string> & v, compressed_string_vector_layout)
+        {
+            const std::size_t start{b.data.size()};
+            return deduplicate(b.add_compressed_string_vector<std::uint32_t>(v), start);
+        }
+
+        template <typename T>
+        auto operator()(const std::vector<std::optional<T>> & v, validity_bitmap_layout)
+        {
+            const std::size_t start{b.data.size()};
+            if constexpr (std::is_same_v<T, std::string>) {
+                return deduplicate(b.add_optional_string_vector<std::uint32_t>(v), start);
+            } else {
+                return deduplicate(b.add_optional_vector<T, std::uint32_t>(std::span{v}), start);
             }
-            return it->second;
+        }
+
+        template <typename T, typename Layout>
+        auto operator()(const with_layout<std::vector<T>, Layout> & v)
+        {
+            return (*this)(static_cast<const std::vector<T> &>(v), Layout{});
         }
 
         template <typename T>
@@ -168,6 +696,15 @@ namespace pid {
             detail::generic_vector_data<typename pid_type<T>::type, std::uint32_t>>
         build(const std::vector<T> & v)
         {
+            if constexpr (
+                std::is_arithmetic_v<T> and std::has_unique_object_representations_v<T>) {
+                // The items are copied at once, so they do not need to be zeroed first
+                auto result{b.add_vector_uninitialized<T, std::uint32_t>(
+                    static_cast<std::uint32_t>(v.size()))};
+                std::copy(v.begin(), v.end(), result->items);
+                return result;
+            }
+
             builder_offset<detail::generic_vector_data<typename pid_type<T>::type, std::uint32_t>>
                 result = b.add_vector<typename pid_type<T>::type, std::uint32_t>(v.size());
 
@@ -178,21 +715,62 @@ namespace pid {
             return result;
         }
 
-        template <typename Key, typename Value>
-        builder_offset<detail::generic_vector_data<
-            std::pair<typename pid_type<Key>::type, typename pid_type<Value>::type>,
-            std::uint32_t>>
-        operator()(const std::map<Key, Value> & m)
+        // The layout of the map can be selected with a tag, e.g., eytzinger_map_layout{}. The
+        // result must then be assigned to a map of the corresponding type.
+        template <typename Key, typename Value, typename Layout = sorted_map_layout>
+        auto operator()(const std::map<Key, Value> & m, Layout = {})
         {
-            auto result{b.add_map<
-                typename pid_type<Key>::type, typename pid_type<Value>::type, std::uint32_t>(
-                m.size())};
+            using KeyType = typename pid_type<Key>::type;
+            using ValueType = typename pid_type<Value>::type;
 
-            for (const auto & [key, value] : m) {
-                *result.add_key((*this)(key)) = (*this)(value);
-            }
+            const std::size_t start{b.data.size()};
+
+            if constexpr (std::is_same_v<Layout, soa_map_layout>) {
+                // The keys and their children are complete before the values are added, so
+                // each vector is removed right away if it is a duplicate
+                auto keys{b.add_vector<KeyType, std::uint32_t>(m.size())};
+                std::size_t index{0};
+                for (const auto & key : std::views::keys(m)) {
+                    (*keys)[index++] = (*this)(key);
+                }
+                const auto unique_keys{deduplicate(keys, start)};
+
+                const std::size_t values_start{b.data.size()};
+                auto values{b.add_vector<ValueType, std::uint32_t>(m.size())};
+                index = 0;
+                for (const auto & value : std::views::values(m)) {
+                    (*values)[index++] = (*this)(value);
+                }
 
-            return result.items;
+                return soa_map_offset<KeyType, ValueType, std::uint32_t>{
+                    unique_keys, deduplicate(values, values_start)};
+            } else {
+                auto result{[&]() {
+                    if constexpr (std::is_same_v<Layout, eytzinger_map_layout>) {
+                        return b.add_eytzinger_map<KeyType, ValueType, std::uint32_t>(m.size());
+                    } else if constexpr (std::is_same_v<Layout, s_tree_map_layout>) {
+                        return b.add_s_tree_map<KeyType, ValueType, std::uint32_t>(m.size());
+                    } else if constexpr (std::is_same_v<Layout, hash_map_layout>) {
+                        return b.add_hash_map<KeyType, ValueType, std::uint32_t>(
+                            std::views::keys(m));
+                    } else {
+                        static_assert(
+                            std::is_same_v<Layout, sorted_map_layout>, "unknown map layout");
+                        return b.add_map<KeyType, ValueType, std::uint32_t>(m.size());
+                    }
+                }()};
+
+                for (const auto & [key, value] : m) {
+                    *result.add_key((*this)(key)) = (*this)(value);
+                }
+
+                if constexpr (std::is_same_v<Layout, s_tree_map_layout>) {
+                    // The search tree is behind the items, and it is not shared
+                    return result.offset();
+                } else {
+                    return deduplicate(result.offset(), start);
+                }
+            }
         }
     };
 
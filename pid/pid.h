@@ -7,11 +7,35 @@
 #include <stdexcept>
 #include <limits>
 #include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <iterator>
+#include <span>
+#include <optional>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
 
 namespace pid {
     template <typename T>
     struct builder_offset;
 
+    template <typename Key, typename Value, typename SizeType>
+    struct soa_map_offset;
+
+    template <typename Key, typename Value, typename SizeType>
+    struct s_tree_map_offset;
+
+    struct prefix_string_offset;
+
+    // Describes how values of type T are stored in a blob, see type-layout.h
+    template <typename T>
+    struct type_layout;
+
     namespace detail {
         template <typename T, typename offset_type>
         struct ptr
@@ -108,6 +132,8 @@ namespace pid {
             using DataType = generic_string_data<SizeType>;
 
         private:
+            template <typename> friend struct pid::type_layout;
+
             ptr<DataType, OffsetType> data;
 
         public:
@@ -173,6 +199,157 @@ namespace pid {
             }
         };
 
+        // String handle which stores the length and the first bytes of the string inline, like
+        // the strings of Umbra and DuckDB. Strings with up to inline_capacity characters are
+        // stored completely in the handle. For longer strings, the handle holds the first
+        // prefix_size characters and a pointer to the whole string, so narrower offsets leave
+        // room for a longer prefix, e.g., 8 characters for 32-bit offsets.
+        //
+        // Most comparisons are decided by the first 8 characters, which are compared as one
+        // number, without following the pointer. The handle takes 16 bytes. Inline strings are
+        // not NUL-terminated.
+        template <typename OffsetType>
+        struct alignas(std::max(alignof(std::uint32_t), alignof(OffsetType)))
+            generic_prefix_string
+        {
+            using DataType = generic_string_data<std::uint32_t>;
+
+            static constexpr std::size_t inline_capacity{12};
+            static constexpr std::size_t prefix_size{inline_capacity - sizeof(OffsetType)};
+
+            // Number of characters which are compared at once
+            static constexpr std::size_t key_size{std::min<std::size_t>(prefix_size, 8)};
+
+        private:
+            template <typename> friend struct pid::type_layout;
+
+            std::uint32_t string_length;
+
+            // The characters of short strings, or the prefix followed by the pointer
+            char chars[inline_capacity];
+
+            bool is_inline() const
+            {
+                return string_length <= inline_capacity;
+            }
+
+            const ptr<DataType, OffsetType> & data() const
+            {
+                return *reinterpret_cast<const ptr<DataType, OffsetType> *>(chars + prefix_size);
+            }
+
+            ptr<DataType, OffsetType> & data()
+            {
+                return *reinterpret_cast<ptr<DataType, OffsetType> *>(chars + prefix_size);
+            }
+
+            // The first key_size characters as a big-endian number, padded with zeros, such that
+            // comparing the numbers gives the order of the prefixes
+            static std::uint64_t prefix_key(const char * p, std::size_t size)
+            {
+                std::uint64_t result{0};
+                std::memcpy(&result, p, std::min(size, key_size));
+                if constexpr (std::endian::native == std::endian::little) {
+                    result = __builtin_bswap64(result);
+                }
+                return result;
+            }
+
+            std::uint64_t prefix_key() const
+            {
+                // The unused characters of short strings are zero
+                return prefix_key(chars, key_size);
+            }
+
+            // Compares the strings, given that their prefix keys are equal
+            std::strong_ordering compare_rest(std::string_view other) const
+            {
+                const std::string_view self{*this};
+                if (self.size() <= key_size or other.size() <= key_size) {
+                    return self <=> other;
+                }
+                return self.substr(key_size) <=> other.substr(key_size);
+            }
+
+            std::strong_ordering compare(std::string_view other) const
+            {
+                const std::uint64_t a{prefix_key()};
+                const std::uint64_t b{prefix_key(other.data(), other.size())};
+                if (a != b) {
+                    return a <=> b;
+                }
+                return compare_rest(other);
+            }
+
+        public:
+            generic_prefix_string(const generic_prefix_string &) = delete;
+
+            generic_prefix_string(generic_prefix_string &&) = delete;
+
+            // Defined in builder.h
+            generic_prefix_string & operator=(const prefix_string_offset & s);
+
+            std::uint32_t size() const
+            {
+                return string_length;
+            }
+
+            bool empty() const
+            {
+                return size() == 0;
+            }
+
+            const char * begin() const
+            {
+                return is_inline() ? chars : data()->begin();
+            }
+
+            const char * end() const
+            {
+                return begin() + size();
+            }
+
+            operator std::string_view() const
+            {
+                return {begin(), end()};
+            }
+
+            template <typename String>
+            bool operator==(const String & other) const
+            {
+                const std::string_view o{other};
+                return o.size() == size() and compare(o) == 0;
+            }
+
+            template <typename String>
+            auto operator<=>(const String & other) const -> std::enable_if_t<
+                std::is_convertible_v<String, std::string_view>, std::strong_ordering>
+            {
+                return compare(other);
+            }
+
+            bool operator==(const generic_prefix_string & other) const
+            {
+                return string_length == other.string_length and (*this <=> other) == 0;
+            }
+
+            std::strong_ordering operator<=>(const generic_prefix_string & other) const
+            {
+                const std::uint64_t a{prefix_key()};
+                const std::uint64_t b{other.prefix_key()};
+                if (a != b) {
+                    return a <=> b;
+                }
+                return compare_rest(other);
+            }
+
+            friend std::ostream & operator<<(
+                std::ostream & o, const generic_prefix_string<OffsetType> & s)
+            {
+                return o << std::string_view{s};
+            }
+        };
+
         template <typename T, typename SizeType>
         struct generic_vector_data
         {
@@ -222,6 +399,8 @@ namespace pid {
             using DataType = generic_vector_data<T, SizeType>;
 
         private:
+            template <typename> friend struct pid::type_layout;
+
             ptr<DataType, OffsetType> data;
 
         public:
@@ -285,6 +464,193 @@ namespace pid {
             }
         };
 
+        // Returns the value of a key. Keys which are stored as pointers are dereferenced.
+        template <typename T>
+        const T & key_value(const T & key)
+        {
+            return key;
+        }
+
+        template <typename T, typename offset_type>
+        const T & key_value(const ptr<T, offset_type> & key)
+        {
+            return *key;
+        }
+
+        // Returns the key of a map item
+        template <typename Key, typename Value>
+        const auto & get_key(const std::pair<Key, Value> & map_item)
+        {
+            return key_value(map_item.first);
+        }
+
+        // Prefetches the part of a key which is not stored in the map item itself
+        template <typename Key>
+        void prefetch_key_data(const Key &)
+        {
+        }
+
+        template <typename OffsetType, typename SizeType>
+        void prefetch_key_data(const generic_string<OffsetType, SizeType> & key)
+        {
+            __builtin_prefetch(key.begin());
+        }
+
+        template <typename T, typename OffsetType>
+        void prefetch_key_data(const ptr<T, OffsetType> & key)
+        {
+            __builtin_prefetch(&*key);
+        }
+
+        // Integer types for which maps use integer_lower_bound() instead of std::lower_bound
+        template <typename T>
+        concept search_integer = std::is_integral_v<T> and not std::is_same_v<T, bool>
+            and not std::is_same_v<T, char> and not std::is_same_v<T, wchar_t>
+            and not std::is_same_v<T, char8_t> and not std::is_same_v<T, char16_t>
+            and not std::is_same_v<T, char32_t>;
+
+        inline bool cpu_has_avx2()
+        {
+#if defined(__x86_64__)
+            static const bool result{__builtin_cpu_supports("avx2") != 0};
+            return result;
+#else
+            return false;
+#endif
+        }
+
+        // Returns how many of 'count' keys, which are 'stride' bytes apart, are less than 'key'
+        template <typename Key>
+        std::size_t count_less_scalar(
+            const char * first, std::size_t stride, std::size_t count, Key key)
+        {
+            std::size_t result{0};
+            for (std::size_t index{0}; index < count; ++index) {
+                result += *reinterpret_cast<const Key *>(first + index * stride) < key;
+            }
+            return result;
+        }
+
+#if defined(__x86_64__)
+        // Same as count_less_scalar for 32 and 64 bit keys, but compares 8 or 4 keys at a
+        // time. Keys which are not contiguous, e.g., in the items of a map, are gathered.
+        template <typename Key>
+        __attribute__((target("avx2"))) std::size_t count_less_avx2(
+            const char * first, std::size_t stride, std::size_t count, Key key)
+        {
+            static_assert(sizeof(Key) == 4 or sizeof(Key) == 8);
+            constexpr std::size_t lanes{32 / sizeof(Key)};
+
+            // Unsigned keys are compared as signed ones after flipping their sign bits
+            constexpr Key bias{
+                std::is_signed_v<Key> ? Key{0} : std::numeric_limits<Key>::max() / 2 + 1};
+            const auto signed_key{static_cast<std::make_signed_t<Key>>(key ^ bias)};
+
+            const auto s{static_cast<long long>(stride)};
+            std::size_t result{0};
+            std::size_t index{0};
+            if constexpr (sizeof(Key) == 4) {
+                const __m256i bias_vector{_mm256_set1_epi32(static_cast<int>(bias))};
+                const __m256i key_vector{_mm256_set1_epi32(signed_key)};
+                const auto i{static_cast<int>(s)};
+                const __m256i indices{
+                    _mm256_setr_epi32(0, i, 2 * i, 3 * i, 4 * i, 5 * i, 6 * i, 7 * i)};
+
+                for (; index + lanes <= count; index += lanes) {
+                    const char * const p{first + index * stride};
+                    const __m256i keys{
+                        stride == sizeof(Key)
+                            ? _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p))
+                            : _mm256_i32gather_epi32(
+                                  reinterpret_cast<const int *>(p), indices, 1)};
+                    const __m256i less{
+                        _mm256_cmpgt_epi32(key_vector, _mm256_xor_si256(keys, bias_vector))};
+                    result += static_cast<std::size_t>(
+                        std::popcount(static_cast<unsigned>(
+                            _mm256_movemask_ps(_mm256_castsi256_ps(less)))));
+                }
+            } else {
+                const __m256i bias_vector{_mm256_set1_epi64x(static_cast<long long>(bias))};
+                const __m256i key_vector{_mm256_set1_epi64x(signed_key)};
+                const __m256i indices{_mm256_setr_epi64x(0, s, 2 * s, 3 * s)};
+
+                for (; index + lanes <= count; index += lanes) {
+                    const char * const p{first + index * stride};
+                    const __m256i keys{
+                        stride == sizeof(Key)
+                            ? _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p))
+                            : _mm256_i64gather_epi64(
+                                  reinterpret_cast<const long long *>(p), indices, 1)};
+                    const __m256i less{
+                        _mm256_cmpgt_epi64(key_vector, _mm256_xor_si256(keys, bias_vector))};
+                    result += static_cast<std::size_t>(
+                        std::popcount(static_cast<unsigned>(
+                            _mm256_movemask_pd(_mm256_castsi256_pd(less)))));
+                }
+            }
+
+            return result
+                + count_less_scalar(first + index * stride, stride, count - index, key);
+        }
+#endif
+
+        template <typename Key>
+        std::size_t count_less(const char * first, std::size_t stride, std::size_t count, Key key)
+        {
+#if defined(__x86_64__)
+            if constexpr (sizeof(Key) == 4 or sizeof(Key) == 8) {
+                // The gather indices are 32 bit integers
+                if (cpu_has_avx2() and stride <= std::numeric_limits<int>::max() / 8) {
+                    return count_less_avx2(first, stride, count, key);
+                }
+            }
+#endif
+            return count_less_scalar(first, stride, count, key);
+        }
+
+        // Lower bound for 'count' sorted integer keys, which are 'stride' bytes apart, e.g.,
+        // the keys of the items of a map. Returns the index of the first key which is not less
+        // than 'key'.
+        //
+        // A branchless binary search narrows the range down to a window of about 256 bytes
+        // (16 to 64 keys), whose keys are then compared all at once with count_less(). This
+        // avoids the mispredicted branches of std::lower_bound, and the last steps of the
+        // search, which would each wait for a load, are replaced by a linear scan.
+        template <typename Key>
+        std::size_t integer_lower_bound(
+            const Key * keys, std::size_t stride, std::size_t count, Key key)
+        {
+            const std::size_t window{std::clamp<std::size_t>(256 / stride, 16, 64)};
+
+            const char * base{reinterpret_cast<const char *>(keys)};
+            std::size_t length{count};
+            while (length > window) {
+                const std::size_t half{length / 2};
+                length -= half;
+                if (*reinterpret_cast<const Key *>(base + half * stride) < key) {
+                    base += half * stride;
+                }
+            }
+
+            return static_cast<std::size_t>(base - reinterpret_cast<const char *>(keys)) / stride
+                + count_less(base, stride, length, key);
+        }
+
+        // Same as integer_lower_bound, but for any integer key, which returns 'count' if
+        // 'key' is greater than all values of Key, and 0 if it is smaller
+        template <typename Key, typename CompatibleKey>
+        std::size_t integer_lower_bound(
+            const Key * keys, std::size_t stride, std::size_t count, CompatibleKey key)
+        {
+            if (std::cmp_less(key, std::numeric_limits<Key>::min())) {
+                return 0;
+            }
+            if (std::cmp_greater(key, std::numeric_limits<Key>::max())) {
+                return count;
+            }
+            return integer_lower_bound(keys, stride, count, static_cast<Key>(key));
+        }
+
         template <typename Key, typename Value, typename OffsetType, typename SizeType>
         struct generic_map
         {
@@ -295,6 +661,8 @@ namespace pid {
             using iterator = const_iterator;
 
         private:
+            template <typename> friend struct pid::type_layout;
+
             VectorType items;
 
         public:
@@ -322,17 +690,30 @@ namespace pid {
             template <typename CompatibleKey>
             const_iterator find(const CompatibleKey & key) const
             {
-                const auto it{std::lower_bound(
-                    items.begin(), items.end(), key,
-                    [](const auto & map_item, const CompatibleKey & key) {
-                        return get_key(map_item) < key;
-                    })};
+                if constexpr (search_integer<Key> and search_integer<CompatibleKey>) {
+                    if (size() == 0) {
+                        return end();
+                    }
+
+                    const auto it{begin() + integer_lower_bound(
+                        &begin()->first, sizeof(ItemType), size(), key)};
+                    if (it == end() or not std::cmp_equal(it->first, key)) {
+                        return end();
+                    }
+                    return it;
+                } else {
+                    const auto it{std::lower_bound(
+                        items.begin(), items.end(), key,
+                        [](const auto & map_item, const CompatibleKey & key) {
+                            return get_key(map_item) < key;
+                        })};
 
-                if (it == items.end() || get_key(*it) != key) {
-                    return end();
-                }
+                    if (it == items.end() || get_key(*it) != key) {
+                        return end();
+                    }
 
-                return it;
+                    return it;
+                }
             }
 
             template <typename CompatibleKey>
@@ -347,104 +728,2110 @@ namespace pid {
                 return it->second;
             }
 
-        private:
-            template <typename T, typename offset_type>
-            static const auto & get_key(const std::pair<ptr<T, offset_type>, Value> & map_item)
+            // Looks up many keys at once and stores the result of find(keys[i]) in results[i].
+            //
+            // The binary searches for a group of keys are interleaved, and the item that each
+            // search will compare next is prefetched while the other searches of the group make
+            // progress. Keys whose data are stored outside of the items, like strings, have
+            // their data prefetched in a separate pass over the group before the comparisons.
+            // This hides the memory latency if the map does not fit into the cache.
+            template <typename CompatibleKey>
+            void find_batch(
+                std::span<const CompatibleKey> keys, std::span<const_iterator> results) const
             {
-                return *map_item.first;
-            }
+                if (keys.size() != results.size()) {
+                    throw std::invalid_argument{"keys and results must have the same size"};
+                }
 
-            template <typename T>
-            static const auto & get_key(const std::pair<T, Value> & map_item)
-            {
-                return map_item.first;
+                constexpr std::size_t group_size{16};
+
+                const std::size_t n{items.size()};
+                if (n == 0) {
+                    std::fill(results.begin(), results.end(), end());
+                    return;
+                }
+
+                const ItemType * base[group_size];
+
+                for (std::size_t group{0}; group < keys.size(); group += group_size) {
+                    const std::size_t count{std::min(group_size, keys.size() - group)};
+                    const CompatibleKey * const group_keys{keys.data() + group};
+
+                    std::fill(base, base + count, items.begin());
+
+                    // Lower bound with a fixed number of steps, see
+                    // https://algorithmica.org/en/binary-search. The search position advances
+                    // without a branch, but comparing keys other than arithmetic ones may branch.
+                    std::size_t length{n};
+                    while (length > 1) {
+                        const std::size_t half{length / 2};
+                        length -= half;
+
+                        if constexpr (not std::is_arithmetic_v<Key>) {
+                            for (std::size_t i{0}; i < count; ++i) {
+                                prefetch_key_data(base[i][half].first);
+                            }
+                        }
+
+                        for (std::size_t i{0}; i < count; ++i) {
+                            base[i] += half
+                                       * static_cast<std::size_t>(
+                                           get_key(base[i][half]) < group_keys[i]);
+                            __builtin_prefetch(base[i] + length / 2);
+                        }
+                    }
+
+                    for (std::size_t i{0}; i < count; ++i) {
+                        const ItemType * it{base[i] + (get_key(*base[i]) < group_keys[i])};
+                        if (it == end() || get_key(*it) != group_keys[i]) {
+                            it = end();
+                        }
+                        results[group + i] = it;
+                    }
+                }
             }
         };
 
-        template <typename Key, typename Value>
-        using map32 = generic_map<Key, Value, std::int32_t, std::uint32_t>;
-    }
-}
-
-namespace pid8 {
-    template <typename T>
-    using ptr = pid::detail::ptr<T, std::int8_t>;
+        // Map whose items are stored in Eytzinger order, i.e., in the breadth-first order of an
+        // implicit binary search tree. The children of the item with the 1-based index k are at
+        // 2k and 2k + 1. Compared to binary search on a sorted array, the first levels of the tree
+        // share a few cache lines, and the items of the next levels can be prefetched because
+        // they are adjacent in memory.
+        //
+        // Note that iterating over the map does not visit the items in the order of their keys.
+        template <typename Key, typename Value, typename OffsetType, typename SizeType>
+        struct generic_eytzinger_map
+        {
+            using ItemType = std::pair<Key, Value>;
+            using VectorType = generic_vector<ItemType, OffsetType, SizeType>;
+            using DataType = typename VectorType::DataType;
+            using const_iterator = typename VectorType::const_iterator;
+            using iterator = const_iterator;
 
-    using string8 = pid::detail::generic_string<std::int8_t, std::uint8_t>;
-    using string16 = pid::detail::generic_string<std::int8_t, std::uint16_t>;
-    using string32 = pid::detail::generic_string<std::int8_t, std::uint32_t>;
-    using string64 = pid::detail::generic_string<std::int8_t, std::uint64_t>;
+        private:
+            template <typename> friend struct pid::type_layout;
 
-    template <typename T>
-    using vector8 = pid::detail::generic_vector<T, std::int8_t, std::uint8_t>;
+            VectorType items;
 
-    template <typename T>
-    using vector16 = pid::detail::generic_vector<T, std::int8_t, std::uint16_t>;
+            // Number of levels below the current item whose first descendant is prefetched. The
+            // 2^levels descendants at that depth are adjacent, and they should fill about one
+            // cache line.
+            static constexpr int prefetch_levels{
+                std::max(1, 6 - static_cast<int>(std::bit_width(sizeof(ItemType) - 1)))};
 
-    template <typename T>
-    using vector32 = pid::detail::generic_vector<T, std::int8_t, std::uint32_t>;
+        public:
+            auto & operator=(builder_offset<generic_vector_data<ItemType, SizeType>> p)
+            {
+                items = p;
+                return *this;
+            }
 
-    template <typename T>
-    using vector64 = pid::detail::generic_vector<T, std::int8_t, std::uint64_t>;
+            SizeType size() const
+            {
+                return items.size();
+            }
 
-    template <typename Key, typename Value>
-    using map8 = pid::detail::generic_map<Key, Value, std::int8_t, std::uint8_t>;
+            [[nodiscard]] const_iterator begin() const
+            {
+                return items.begin();
+            }
 
-    template <typename Key, typename Value>
-    using map16 = pid::detail::generic_map<Key, Value, std::int8_t, std::uint16_t>;
+            [[nodiscard]] const_iterator end() const
+            {
+                return items.end();
+            }
 
-    template <typename Key, typename Value>
-    using map32 = pid::detail::generic_map<Key, Value, std::int8_t, std::uint32_t>;
+            template <typename CompatibleKey>
+            const_iterator find(const CompatibleKey & key) const
+            {
+                const std::size_t n{items.size()};
+                const ItemType * const data{items.begin()};
 
-    template <typename Key, typename Value>
-    using map64 = pid::detail::generic_map<Key, Value, std::int8_t, std::uint64_t>;
-}
+                std::size_t k{1};
+                while (k <= n) {
+                    __builtin_prefetch(data + (k << prefetch_levels) - 1);
+                    k = 2 * k + (get_key(data[k - 1]) < key);
+                }
 
-namespace pid16 {
-    template <typename T>
-    using ptr = pid::detail::ptr<T, std::int16_t>;
+                // Undo the right turns and the final left turn to get the lower bound.
+                k >>= std::countr_one(k) + 1;
 
-    using string8 = pid::detail::generic_string<std::int16_t, std::uint8_t>;
-    using string16 = pid::detail::generic_string<std::int16_t, std::uint16_t>;
-    using string32 = pid::detail::generic_string<std::int16_t, std::uint32_t>;
-    using string64 = pid::detail::generic_string<std::int16_t, std::uint64_t>;
+                if (k == 0 || get_key(data[k - 1]) != key) {
+                    return end();
+                }
 
-    template <typename T>
-    using vector8 = pid::detail::generic_vector<T, std::int16_t, std::uint8_t>;
+                return data + (k - 1);
+            }
 
-    template <typename T>
-    using vector16 = pid::detail::generic_vector<T, std::int16_t, std::uint16_t>;
+            template <typename CompatibleKey>
+            const Value & at(const CompatibleKey & key) const
+            {
+                const auto it{find(key)};
 
-    template <typename T>
-    using vector32 = pid::detail::generic_vector<T, std::int16_t, std::uint32_t>;
+                if (it == end()) {
+                    throw std::out_of_range{"key not found"};
+                }
 
-    template <typename T>
-    using vector64 = pid::detail::generic_vector<T, std::int16_t, std::uint64_t>;
+                return it->second;
+            }
+        };
 
-    template <typename Key, typename Value>
-    using map8 = pid::detail::generic_map<Key, Value, std::int16_t, std::uint8_t>;
+        // Hash functions for keys which are stored in blobs. Unlike std::hash, the results are
+        // specified by this library, such that they can be computed at build time and stored in
+        // the blob.
+        constexpr std::uint64_t mix_hash(std::uint64_t x)
+        {
+            // Finalizer of splitmix64
+            x ^= x >> 30;
+            x *= 0xbf58476d1ce4e5b9;
+            x ^= x >> 27;
+            x *= 0x94d049bb133111eb;
+            x ^= x >> 31;
+            return x;
+        }
+
+        inline std::uint64_t hash_bytes(std::string_view s, std::uint64_t seed)
+        {
+            std::uint64_t result{seed ^ (s.size() * 0x9e3779b97f4a7c15)};
+
+            const char * p{s.data()};
+            std::size_t remaining{s.size()};
+            for (; remaining >= 8; remaining -= 8, p += 8) {
+                std::uint64_t word;
+                std::memcpy(&word, p, 8);
+                result = mix_hash(result ^ word);
+            }
 
-    template <typename Key, typename Value>
-    using map16 = pid::detail::generic_map<Key, Value, std::int16_t, std::uint16_t>;
+            if (remaining > 0) {
+                std::uint64_t word{0};
+                std::memcpy(&word, p, remaining);
+                result = mix_hash(result ^ word);
+            }
 
-    template <typename Key, typename Value>
-    using map32 = pid::detail::generic_map<Key, Value, std::int16_t, std::uint32_t>;
+            return mix_hash(result);
+        }
 
-    template <typename Key, typename Value>
-    using map64 = pid::detail::generic_map<Key, Value, std::int16_t, std::uint64_t>;
-}
+        template <typename T>
+        std::uint64_t hash_key(const T & key, std::uint64_t seed)
+        {
+            if constexpr (std::is_integral_v<T> || std::is_enum_v<T>) {
+                return mix_hash(seed ^ static_cast<std::uint64_t>(key));
+            } else {
+                static_assert(
+                    std::is_convertible_v<const T &, std::string_view>,
+                    "keys must be integers, enums, or strings");
+                return hash_bytes(std::string_view{key}, seed);
+            }
+        }
 
-namespace pid32 {
-    template <typename T>
-    using ptr = pid::detail::ptr<T, std::int32_t>;
+        // Like generic_string_data, but with the hash of the string, which is computed by the
+        // builder, see generic_hashed_string
+        template <typename SizeType>
+        struct generic_hashed_string_data
+        {
+            std::uint64_t string_hash;
+            SizeType string_length;
+            char data[];
 
-    using string8 = pid::detail::generic_string<std::int32_t, std::uint8_t>;
-    using string16 = pid::detail::generic_string<std::int32_t, std::uint16_t>;
-    using string32 = pid::detail::generic_string<std::int32_t, std::uint32_t>;
-    using string64 = pid::detail::generic_string<std::int32_t, std::uint64_t>;
+            generic_hashed_string_data(const generic_hashed_string_data &) = delete;
 
-    template <typename T>
-    using vector8 = pid::detail::generic_vector<T, std::int32_t, std::uint8_t>;
+            generic_hashed_string_data(generic_hashed_string_data &&) = delete;
+
+            static std::uint64_t hash_of(std::string_view s)
+            {
+                return hash_bytes(s, 0);
+            }
+
+            const char * begin() const
+            {
+                return data;
+            }
+
+            const char * end() const
+            {
+                return data + string_length;
+            }
+
+            operator std::string_view() const
+            {
+                return {begin(), end()};
+            }
+        };
+
+        // String which stores its hash, such that hash tables and joins over strings of a blob
+        // do not need to hash them again. Comparisons for equality with other hashed strings
+        // fail fast if the hashes differ, and equals() does the same for strings whose hash the
+        // caller has computed once with hash_of().
+        template <typename OffsetType, typename SizeType>
+        struct generic_hashed_string
+        {
+            using DataType = generic_hashed_string_data<SizeType>;
+
+        private:
+            template <typename> friend struct pid::type_layout;
+
+            ptr<DataType, OffsetType> data;
+
+        public:
+            generic_hashed_string(const generic_hashed_string &) = delete;
+
+            generic_hashed_string(generic_hashed_string &&) = delete;
+
+            generic_hashed_string(builder_offset<DataType> p)
+            {
+                *this = p;
+            }
+
+            auto & operator=(builder_offset<DataType> p)
+            {
+                p.assign_to(data);
+                return *this;
+            }
+
+            static std::uint64_t hash_of(std::string_view s)
+            {
+                return DataType::hash_of(s);
+            }
+
+            std::uint64_t hash() const
+            {
+                return data->string_hash;
+            }
+
+            SizeType size() const
+            {
+                return data->string_length;
+            }
+
+            bool empty() const
+            {
+                return size() == 0;
+            }
+
+            const char * begin() const
+            {
+                return data->begin();
+            }
+
+            const char * end() const
+            {
+                return data->end();
+            }
+
+            operator std::string_view() const
+            {
+                return {begin(), end()};
+            }
+
+            // 'hash' must be hash_of(s)
+            bool equals(std::string_view s, std::uint64_t hash) const
+            {
+                return hash == data->string_hash and std::string_view{*this} == s;
+            }
+
+            template <typename OtherOffsetType, typename OtherSizeType>
+            bool operator==(const generic_hashed_string<OtherOffsetType, OtherSizeType> & other)
+                const
+            {
+                return equals(other, other.hash());
+            }
+
+            template <typename String>
+            bool operator==(const String & other) const
+            {
+                return std::string_view{*this} == other;
+            }
+
+            template <typename String>
+            auto operator<=>(const String & other) const -> std::enable_if_t<
+                std::is_convertible_v<String, std::string_view>, std::strong_ordering>
+            {
+                return std::string_view{*this} <=> other;
+            }
+
+            friend std::ostream & operator<<(
+                std::ostream & o, const generic_hashed_string<OffsetType, SizeType> & s)
+            {
+                return o << std::string_view{s};
+            }
+        };
+
+        // Data of a generic_hash_map. The items are stored at the positions that are given by
+        // a minimal perfect hash function, which is built with the PTHash algorithm: the keys
+        // are distributed to buckets by their hash, and for each bucket, a 'pilot' value is
+        // chosen such that the positions of all keys in the bucket are free.
+        template <typename Key, typename Value, typename SizeType>
+        struct alignas(std::max(alignof(std::uint64_t), alignof(std::pair<Key, Value>)))
+            generic_hash_map_data
+        {
+            using ItemType = std::pair<Key, Value>;
+
+            std::uint64_t seed;
+            SizeType map_size;
+            SizeType bucket_count;
+            std::uint32_t pilots[];
+
+            generic_hash_map_data(const generic_hash_map_data &) = delete;
+
+            generic_hash_map_data(generic_hash_map_data &&) = delete;
+
+            static std::size_t items_offset(std::size_t bucket_count)
+            {
+                const std::size_t pilots_end{
+                    offsetof(generic_hash_map_data, pilots)
+                    + bucket_count * sizeof(std::uint32_t)};
+                constexpr std::size_t alignment{alignof(ItemType)};
+                return (pilots_end + alignment - 1) / alignment * alignment;
+            }
+
+            // Size of the pilots and items, which are stored behind the fixed-size members
+            static std::size_t extra_bytes(std::size_t map_size, std::size_t bucket_count)
+            {
+                return items_offset(bucket_count) + map_size * sizeof(ItemType)
+                       - sizeof(generic_hash_map_data);
+            }
+
+            static std::size_t bucket(std::uint64_t hash, std::size_t bucket_count)
+            {
+                return static_cast<std::size_t>(
+                    (static_cast<unsigned __int128>(hash) * bucket_count) >> 64);
+            }
+
+            static std::size_t position(std::uint64_t hash, std::uint32_t pilot, std::size_t size)
+            {
+                const std::uint64_t h{mix_hash(hash ^ mix_hash(pilot))};
+                return static_cast<std::size_t>((static_cast<unsigned __int128>(h) * size) >> 64);
+            }
+
+            std::size_t position(std::uint64_t hash) const
+            {
+                return position(hash, pilots[bucket(hash, bucket_count)], map_size);
+            }
+
+            const ItemType * items() const
+            {
+                return reinterpret_cast<const ItemType *>(
+                    reinterpret_cast<const char *>(this) + items_offset(bucket_count));
+            }
+
+            ItemType * items()
+            {
+                return reinterpret_cast<ItemType *>(
+                    reinterpret_cast<char *>(this) + items_offset(bucket_count));
+            }
+        };
+
+        // Read-only hash map with O(1) lookups: finding a key reads one pilot value and one
+        // item, and compares the key of that item with the requested key.
+        //
+        // Iterating over the map visits the items in the order of their hash positions.
+        template <typename Key, typename Value, typename OffsetType, typename SizeType>
+        struct generic_hash_map
+        {
+            using DataType = generic_hash_map_data<Key, Value, SizeType>;
+            using ItemType = typename DataType::ItemType;
+            using const_iterator = const ItemType *;
+            using iterator = const_iterator;
+
+        private:
+            template <typename> friend struct pid::type_layout;
+
+            ptr<DataType, OffsetType> data;
+
+        public:
+            auto & operator=(builder_offset<DataType> p)
+            {
+                p.assign_to(data);
+                return *this;
+            }
+
+            SizeType size() const
+            {
+                return data->map_size;
+            }
+
+            bool empty() const
+            {
+                return size() == 0;
+            }
+
+            [[nodiscard]] const_iterator begin() const
+            {
+                return data->items();
+            }
+
+            [[nodiscard]] const_iterator end() const
+            {
+                return data->items() + data->map_size;
+            }
+
+            template <typename CompatibleKey>
+            const_iterator find(const CompatibleKey & key) const
+            {
+                const DataType & d{*data};
+                if (d.map_size == 0) {
+                    return end();
+                }
+
+                const ItemType & item{d.items()[d.position(hash_key(key, d.seed))]};
+                if (get_key(item) != key) {
+                    return end();
+                }
+
+                return &item;
+            }
+
+            template <typename CompatibleKey>
+            const Value & at(const CompatibleKey & key) const
+            {
+                const auto it{find(key)};
+
+                if (it == end()) {
+                    throw std::out_of_range{"key not found"};
+                }
+
+                return it->second;
+            }
+        };
+
+        // Iterator over a map whose keys and values are stored in separate arrays. It yields
+        // pairs of references to a key and the corresponding value.
+        template <typename Key, typename Value>
+        struct soa_map_iterator
+        {
+            using iterator_category = std::random_access_iterator_tag;
+            using difference_type = std::ptrdiff_t;
+            using value_type = std::pair<const Key &, const Value &>;
+            using reference = value_type;
+
+            struct pointer
+            {
+                value_type item;
+
+                const value_type * operator->() const
+                {
+                    return &item;
+                }
+            };
+
+            const Key * key;
+            const Value * value;
+
+            reference operator*() const
+            {
+                return {*key, *value};
+            }
+
+            pointer operator->() const
+            {
+                return {**this};
+            }
+
+            reference operator[](difference_type n) const
+            {
+                return *(*this + n);
+            }
+
+            soa_map_iterator & operator++()
+            {
+                ++key;
+                ++value;
+                return *this;
+            }
+
+            soa_map_iterator operator++(int)
+            {
+                auto result{*this};
+                ++*this;
+                return result;
+            }
+
+            soa_map_iterator & operator--()
+            {
+                --key;
+                --value;
+                return *this;
+            }
+
+            soa_map_iterator operator--(int)
+            {
+                auto result{*this};
+                --*this;
+                return result;
+            }
+
+            soa_map_iterator & operator+=(difference_type n)
+            {
+                key += n;
+                value += n;
+                return *this;
+            }
+
+            soa_map_iterator & operator-=(difference_type n)
+            {
+                return *this += -n;
+            }
+
+            friend soa_map_iterator operator+(soa_map_iterator it, difference_type n)
+            {
+                return it += n;
+            }
+
+            friend soa_map_iterator operator+(difference_type n, soa_map_iterator it)
+            {
+                return it += n;
+            }
+
+            friend soa_map_iterator operator-(soa_map_iterator it, difference_type n)
+            {
+                return it -= n;
+            }
+
+            friend difference_type operator-(
+                const soa_map_iterator & a, const soa_map_iterator & b)
+            {
+                return a.key - b.key;
+            }
+
+            friend bool operator==(const soa_map_iterator & a, const soa_map_iterator & b)
+            {
+                return a.key == b.key;
+            }
+
+            friend auto operator<=>(const soa_map_iterator & a, const soa_map_iterator & b)
+            {
+                return a.key <=> b.key;
+            }
+        };
+
+        // Map which stores the sorted keys and the values in two separate vectors ("structure
+        // of arrays"). Binary search only touches the cache lines of the keys, which is faster
+        // than generic_map if the values are large.
+        template <typename Key, typename Value, typename OffsetType, typename SizeType>
+        struct generic_soa_map
+        {
+            using KeyVectorType = generic_vector<Key, OffsetType, SizeType>;
+            using ValueVectorType = generic_vector<Value, OffsetType, SizeType>;
+            using const_iterator = soa_map_iterator<Key, Value>;
+            using iterator = const_iterator;
+
+        private:
+            template <typename> friend struct pid::type_layout;
+
+            KeyVectorType key_vector;
+            ValueVectorType value_vector;
+
+        public:
+            auto & operator=(const soa_map_offset<Key, Value, SizeType> & p)
+            {
+                key_vector = p.keys;
+                value_vector = p.values;
+                return *this;
+            }
+
+            SizeType size() const
+            {
+                return key_vector.size();
+            }
+
+            bool empty() const
+            {
+                return size() == 0;
+            }
+
+            const KeyVectorType & keys() const
+            {
+                return key_vector;
+            }
+
+            const ValueVectorType & values() const
+            {
+                return value_vector;
+            }
+
+            [[nodiscard]] const_iterator begin() const
+            {
+                return {key_vector.begin(), value_vector.begin()};
+            }
+
+            [[nodiscard]] const_iterator end() const
+            {
+                return {key_vector.end(), value_vector.end()};
+            }
+
+            template <typename CompatibleKey>
+            const_iterator find(const CompatibleKey & key) const
+            {
+                if constexpr (search_integer<Key> and search_integer<CompatibleKey>) {
+                    if (empty()) {
+                        return end();
+                    }
+
+                    const std::size_t index{
+                        integer_lower_bound(key_vector.begin(), sizeof(Key), size(), key)};
+                    if (index == size() or not std::cmp_equal(key_vector[index], key)) {
+                        return end();
+                    }
+                    return begin() + static_cast<std::ptrdiff_t>(index);
+                } else {
+                    const auto it{std::lower_bound(
+                        key_vector.begin(), key_vector.end(), key,
+                        [](const auto & k, const CompatibleKey & key) {
+                            return key_value(k) < key;
+                        })};
+
+                    if (it == key_vector.end() || key_value(*it) != key) {
+                        return end();
+                    }
+
+                    return begin() + (it - key_vector.begin());
+                }
+            }
+
+            template <typename CompatibleKey>
+            const Value & at(const CompatibleKey & key) const
+            {
+                const auto it{find(key)};
+
+                if (it == end()) {
+                    throw std::out_of_range{"key not found"};
+                }
+
+                return it->second;
+            }
+        };
+
+        // Data of a generic_s_tree_map: a static B+ tree ("S+ tree") over the sorted keys of
+        // the map, see https://algorithmica.org/en/b-tree. The nodes have node_size keys and
+        // node_size + 1 children, and are stored layer by layer, from the leaves to the root.
+        // The leaves contain all keys. Key j of an inner node is the smallest key in the
+        // subtree of child j + 1. Missing keys are padded with the largest value of Key.
+        //
+        // The keys start behind 'padding' bytes, such that the nodes start at cache line
+        // boundaries if the blob does. The offsets of the layers are stored, because computing
+        // them takes longer than a lookup in a small tree.
+        template <typename Key, typename SizeType>
+        struct alignas(std::max(alignof(Key), alignof(std::uint64_t))) generic_s_tree_data
+        {
+            static_assert(search_integer<Key>);
+
+            // The nodes of 32 bit keys fill one cache line
+            static constexpr std::size_t node_size{16};
+            static constexpr std::size_t cache_line_size{64};
+
+            // Enough for any number of keys
+            static constexpr std::size_t max_layers{16};
+
+            SizeType key_count;
+            SizeType padding;
+            std::uint32_t layer_count;
+
+            // Index in keys() of the first key of each layer, starting with the leaves
+            std::uint64_t layer_offsets[max_layers];
+
+            generic_s_tree_data(const generic_s_tree_data &) = delete;
+
+            generic_s_tree_data(generic_s_tree_data &&) = delete;
+
+            // Stores the number of nodes of each layer, starting with the leaves, in 'nodes',
+            // and returns the number of layers
+            static std::size_t layers(std::size_t key_count, std::size_t (&nodes)[max_layers])
+            {
+                if (key_count == 0) {
+                    return 0;
+                }
+
+                std::size_t count{0};
+                std::size_t n{(key_count + node_size - 1) / node_size};
+                nodes[count++] = n;
+                while (n > 1) {
+                    n = (n + node_size) / (node_size + 1);
+                    nodes[count++] = n;
+                }
+                return count;
+            }
+
+            // Returns the number of keys in all nodes
+            static std::size_t index_size(std::size_t key_count)
+            {
+                std::size_t nodes[max_layers];
+                const std::size_t count{layers(key_count, nodes)};
+
+                std::size_t result{0};
+                for (std::size_t layer{0}; layer < count; ++layer) {
+                    result += nodes[layer] * node_size;
+                }
+                return result;
+            }
+
+            // Stores the offset of each layer in 'offsets', where unused layers start at the
+            // end, and returns the number of layers
+            static std::size_t layer_offsets_of(
+                std::size_t key_count, std::uint64_t (&offsets)[max_layers])
+            {
+                std::size_t nodes[max_layers];
+                const std::size_t count{layers(key_count, nodes)};
+
+                std::uint64_t offset{0};
+                for (std::size_t layer{0}; layer < max_layers; ++layer) {
+                    offsets[layer] = offset;
+                    if (layer < count) {
+                        offset += nodes[layer] * node_size;
+                    }
+                }
+                return count;
+            }
+
+            void set_key_count(SizeType count)
+            {
+                key_count = count;
+                layer_count = static_cast<std::uint32_t>(layer_offsets_of(count, layer_offsets));
+            }
+
+            static std::size_t extra_bytes(std::size_t key_count)
+            {
+                return cache_line_size - alignof(Key) + index_size(key_count) * sizeof(Key);
+            }
+
+            // Calls f(position) for each position in keys() at which the key with the given
+            // rank is stored
+            template <typename Function>
+            static void positions(std::size_t key_count, std::size_t rank, Function f)
+            {
+                std::size_t nodes[max_layers];
+                const std::size_t count{layers(key_count, nodes)};
+
+                f(rank);
+
+                // The key is in layer + 1 if it is the first key of a node in 'layer' which is
+                // not the first child of its parent
+                std::size_t layer_offset{0};
+                std::size_t keys_per_node{node_size};
+                for (std::size_t layer{0}; layer + 1 < count; ++layer) {
+                    layer_offset += nodes[layer] * node_size;
+                    if (rank % keys_per_node != 0) {
+                        break;
+                    }
+
+                    const std::size_t node{rank / keys_per_node};
+                    if (node % (node_size + 1) != 0) {
+                        f(layer_offset + node / (node_size + 1) * node_size
+                          + node % (node_size + 1) - 1);
+                    }
+                    keys_per_node *= node_size + 1;
+                }
+            }
+
+            const Key * keys() const
+            {
+                return reinterpret_cast<const Key *>(
+                    reinterpret_cast<const char *>(this + 1) + padding);
+            }
+
+            Key * keys()
+            {
+                return reinterpret_cast<Key *>(reinterpret_cast<char *>(this + 1) + padding);
+            }
+
+            // Returns the rank of the first key which is not less than 'key'. Each layer costs
+            // one cache miss, and the keys of a node are compared at once with count_less().
+            std::size_t lower_bound(Key key) const
+            {
+                if (layer_count == 0) {
+                    return 0;
+                }
+
+                const char * const first{reinterpret_cast<const char *>(keys())};
+                std::size_t node{0};
+                for (std::size_t layer{layer_count - 1}; layer > 0; --layer) {
+                    const std::size_t position{layer_offsets[layer] + node * node_size};
+                    node = node * (node_size + 1)
+                        + count_less(first + position * sizeof(Key), sizeof(Key), node_size, key);
+                }
+
+                return node * node_size
+                    + count_less(
+                           first + node * node_size * sizeof(Key), sizeof(Key), node_size, key);
+            }
+        };
+
+        // Map with integer keys whose items are stored in sorted order like in generic_map,
+        // and which has an additional static search tree over the keys, see
+        // generic_s_tree_data. Lookups only touch one node per layer of the tree, i.e., about
+        // log17(n) cache lines for 32 bit keys, and then the item. This pays off for maps which
+        // do not fit into the cache; smaller maps are searched faster by generic_map.
+        //
+        // The tree takes about as much space as a copy of the keys.
+        template <typename Key, typename Value, typename OffsetType, typename SizeType>
+        struct generic_s_tree_map
+        {
+            using ItemType = std::pair<Key, Value>;
+            using VectorType = generic_vector<ItemType, OffsetType, SizeType>;
+            using IndexDataType = generic_s_tree_data<Key, SizeType>;
+            using const_iterator = typename VectorType::const_iterator;
+            using iterator = const_iterator;
+
+        private:
+            template <typename> friend struct pid::type_layout;
+
+            VectorType items;
+            ptr<IndexDataType, OffsetType> index;
+
+        public:
+            auto & operator=(const s_tree_map_offset<Key, Value, SizeType> & p)
+            {
+                items = p.items;
+                p.index.assign_to(index);
+                return *this;
+            }
+
+            SizeType size() const
+            {
+                return items.size();
+            }
+
+            bool empty() const
+            {
+                return size() == 0;
+            }
+
+            [[nodiscard]] const_iterator begin() const
+            {
+                return items.begin();
+            }
+
+            [[nodiscard]] const_iterator end() const
+            {
+                return items.end();
+            }
+
+            template <typename CompatibleKey>
+            const_iterator lower_bound(const CompatibleKey & key) const
+            {
+                static_assert(search_integer<CompatibleKey>);
+
+                if (std::cmp_less(key, std::numeric_limits<Key>::min())) {
+                    return begin();
+                }
+                if (std::cmp_greater(key, std::numeric_limits<Key>::max())) {
+                    return end();
+                }
+                return begin() + index->lower_bound(static_cast<Key>(key));
+            }
+
+            template <typename CompatibleKey>
+            const_iterator upper_bound(const CompatibleKey & key) const
+            {
+                const auto it{lower_bound(key)};
+                return it != end() and std::cmp_equal(it->first, key) ? it + 1 : it;
+            }
+
+            // Returns the items whose keys are in [low, high)
+            template <typename CompatibleKey>
+            std::span<const ItemType> range(
+                const CompatibleKey & low, const CompatibleKey & high) const
+            {
+                const auto last{lower_bound(high)};
+                return {std::min(lower_bound(low), last), last};
+            }
+
+            template <typename CompatibleKey>
+            const_iterator find(const CompatibleKey & key) const
+            {
+                const auto it{lower_bound(key)};
+                if (it == end() or not std::cmp_equal(it->first, key)) {
+                    return end();
+                }
+                return it;
+            }
+
+            template <typename CompatibleKey>
+            const Value & at(const CompatibleKey & key) const
+            {
+                const auto it{find(key)};
+
+                if (it == end()) {
+                    throw std::out_of_range{"key not found"};
+                }
+
+                return it->second;
+            }
+        };
+
+        // Iterator for containers whose items are computed on access, e.g., because they are
+        // decoded or assembled from several arrays. It yields the items by value.
+        template <typename Container>
+        struct index_iterator
+        {
+            using iterator_category = std::forward_iterator_tag;
+            using difference_type = std::ptrdiff_t;
+            using value_type = decltype(std::declval<const Container &>()[0]);
+            using reference = value_type;
+
+            const Container * container;
+            std::size_t index;
+
+            value_type operator*() const
+            {
+                return (*container)[index];
+            }
+
+            index_iterator & operator++()
+            {
+                ++index;
+                return *this;
+            }
+
+            index_iterator operator++(int)
+            {
+                auto result{*this};
+                ++index;
+                return result;
+            }
+
+            friend bool operator==(const index_iterator & a, const index_iterator & b)
+            {
+                return a.index == b.index;
+            }
+        };
+
+        // Extracts 'count' consecutive fields of 'width' bits, starting at bit 'first_bit' of
+        // 'words'. The word behind the last field must be readable.
+        inline void unpack_bits_scalar(
+            const std::uint64_t * words, std::size_t first_bit, unsigned width,
+            std::size_t count, std::uint64_t * out)
+        {
+            const std::uint64_t mask{width == 0 ? 0 : ~std::uint64_t{0} >> (64 - width)};
+
+            for (std::size_t index{0}; index < count; ++index) {
+                const std::size_t bit{first_bit + index * width};
+                const std::size_t shift{bit % 64};
+                const std::uint64_t low{words[bit / 64] >> shift};
+                // Shift in two steps to avoid shifting by 64 if 'shift' is 0
+                const std::uint64_t high{(words[bit / 64 + 1] << 1) << (63 - shift)};
+                out[index] = (low | high) & mask;
+            }
+        }
+
+#if defined(__x86_64__)
+        // Same as unpack_bits_scalar, but extracts four fields at a time with AVX2 gathers and
+        // variable shifts.
+        __attribute__((target("avx2"))) inline void unpack_bits_avx2(
+            const std::uint64_t * words, std::size_t first_bit, unsigned width,
+            std::size_t count, std::uint64_t * out)
+        {
+            const std::uint64_t mask{width == 0 ? 0 : ~std::uint64_t{0} >> (64 - width)};
+
+            const __m256i mask_vector{_mm256_set1_epi64x(static_cast<long long>(mask))};
+            const __m256i step{_mm256_set1_epi64x(static_cast<long long>(4 * width))};
+            const __m256i sixty_three{_mm256_set1_epi64x(63)};
+            const __m256i sixty_four{_mm256_set1_epi64x(64)};
+            __m256i bits{_mm256_add_epi64(
+                _mm256_set1_epi64x(static_cast<long long>(first_bit)),
+                _mm256_setr_epi64x(0, width, 2 * width, 3 * width))};
+
+            const auto base{reinterpret_cast<const long long *>(words)};
+
+            std::size_t index{0};
+            for (; index + 4 <= count; index += 4) {
+                const __m256i word_index{_mm256_srli_epi64(bits, 6)};
+                const __m256i shift{_mm256_and_si256(bits, sixty_three)};
+
+                const __m256i low_words{_mm256_i64gather_epi64(base, word_index, 8)};
+                const __m256i high_words{_mm256_i64gather_epi64(base + 1, word_index, 8)};
+
+                // Variable shifts by 64 yield 0, which is what we need if 'shift' is 0
+                const __m256i value{_mm256_or_si256(
+                    _mm256_srlv_epi64(low_words, shift),
+                    _mm256_sllv_epi64(high_words, _mm256_sub_epi64(sixty_four, shift)))};
+
+                _mm256_storeu_si256(
+                    reinterpret_cast<__m256i *>(out + index),
+                    _mm256_and_si256(value, mask_vector));
+
+                bits = _mm256_add_epi64(bits, step);
+            }
+
+            unpack_bits_scalar(
+                words, first_bit + index * width, width, count - index, out + index);
+        }
+#endif
+
+        inline void unpack_bits(
+            const std::uint64_t * words, std::size_t first_bit, unsigned width,
+            std::size_t count, std::uint64_t * out)
+        {
+#if defined(__x86_64__)
+            if (cpu_has_avx2()) {
+                unpack_bits_avx2(words, first_bit, width, count, out);
+                return;
+            }
+#endif
+            unpack_bits_scalar(words, first_bit, width, count, out);
+        }
+
+        // Data of a generic_packed_vector. The values are divided into blocks, and each value
+        // is stored as the difference to the smallest value in its block ("frame of
+        // reference"), using the number of bits of the largest difference in the block. This
+        // works well for small numbers, and also for large numbers which are sorted or
+        // clustered, like timestamps. An outlier only widens its own block.
+        //
+        // 'words' contains two words for each block: its smallest value, and the position of
+        // its first bit in the packed differences times 256 plus its bit width. They are
+        // followed by the bit-packed differences and one padding word.
+        template <typename T, typename SizeType>
+        struct generic_packed_vector_data
+        {
+            static_assert(std::is_integral_v<T> && sizeof(T) <= sizeof(std::uint64_t));
+
+            static constexpr std::size_t block_size{128};
+
+            SizeType vector_length;
+            std::uint64_t words[];
+
+            generic_packed_vector_data(const generic_packed_vector_data &) = delete;
+
+            generic_packed_vector_data(generic_packed_vector_data &&) = delete;
+
+            static std::size_t block_count(std::size_t size)
+            {
+                return (size + block_size - 1) / block_size;
+            }
+
+            // 'bit_count' is the number of bits of all packed differences
+            static std::size_t word_count(std::size_t size, std::size_t bit_count)
+            {
+                return 2 * block_count(size) + (bit_count + 63) / 64 + 1;
+            }
+
+            static std::uint64_t block_position(std::size_t first_bit, unsigned bit_width)
+            {
+                return std::uint64_t{first_bit} << 8 | bit_width;
+            }
+
+            SizeType size() const
+            {
+                return vector_length;
+            }
+
+            std::uint64_t block_minimum(std::size_t block) const
+            {
+                return words[2 * block];
+            }
+
+            unsigned bit_width(std::size_t block) const
+            {
+                return static_cast<unsigned>(words[2 * block + 1] & 0xff);
+            }
+
+            std::size_t first_bit(std::size_t block) const
+            {
+                return static_cast<std::size_t>(words[2 * block + 1] >> 8);
+            }
+
+            const std::uint64_t * packed() const
+            {
+                return words + 2 * block_count(vector_length);
+            }
+
+            T operator[](SizeType index) const
+            {
+                const std::size_t block{static_cast<std::size_t>(index) / block_size};
+                const unsigned width{bit_width(block)};
+                const std::size_t bit{
+                    first_bit(block) + static_cast<std::size_t>(index) % block_size * width};
+                const std::size_t shift{bit % 64};
+                const std::uint64_t mask{width == 0 ? 0 : ~std::uint64_t{0} >> (64 - width)};
+
+                const std::uint64_t low{packed()[bit / 64] >> shift};
+                const std::uint64_t high{(packed()[bit / 64 + 1] << 1) << (63 - shift)};
+
+                return static_cast<T>(block_minimum(block) + ((low | high) & mask));
+            }
+
+            // Decodes 'count' values, starting at 'first', into 'out'
+            void decode(SizeType first, SizeType count, T * out) const
+            {
+                std::uint64_t buffer[block_size];
+
+                std::size_t index{first};
+                const std::size_t last{static_cast<std::size_t>(first) + count};
+                while (index < last) {
+                    const std::size_t block{index / block_size};
+                    const std::size_t n{std::min(last, (block + 1) * block_size) - index};
+                    const unsigned width{bit_width(block)};
+
+                    unpack_bits(
+                        packed(), first_bit(block) + (index % block_size) * width, width, n,
+                        buffer);
+
+                    const std::uint64_t block_base{block_minimum(block)};
+                    for (std::size_t i{0}; i < n; ++i) {
+                        out[i] = static_cast<T>(block_base + buffer[i]);
+                    }
+
+                    out += n;
+                    index += n;
+                }
+            }
+        };
+
+        // Vector of integers which are bit-packed, see generic_packed_vector_data. Random access
+        // is O(1). For sequential scans, decode() is faster than accessing the items one by one.
+        template <typename T, typename OffsetType, typename SizeType>
+        struct generic_packed_vector
+        {
+            using DataType = generic_packed_vector_data<T, SizeType>;
+            using const_iterator = index_iterator<DataType>;
+            using iterator = const_iterator;
+
+        private:
+            template <typename> friend struct pid::type_layout;
+
+            ptr<DataType, OffsetType> data;
+
+        public:
+            auto & operator=(builder_offset<DataType> p)
+            {
+                p.assign_to(data);
+                return *this;
+            }
+
+            SizeType size() const
+            {
+                return data->size();
+            }
+
+            bool empty() const
+            {
+                return size() == 0;
+            }
+
+            // Number of bits of each value in the block which contains the value at 'index'
+            unsigned bit_width(SizeType index) const
+            {
+                return data->bit_width(static_cast<std::size_t>(index) / DataType::block_size);
+            }
+
+            [[nodiscard]] const_iterator begin() const
+            {
+                return {&*data, 0};
+            }
+
+            [[nodiscard]] const_iterator end() const
+            {
+                return {&*data, size()};
+            }
+
+            T operator[](SizeType index) const
+            {
+                return (*data)[index];
+            }
+
+            T at(SizeType index) const
+            {
+                if (index >= 0 and index < size()) {
+                    return (*data)[index];
+                } else {
+                    throw std::out_of_range{"index out of range"};
+                }
+            }
+
+            void decode(SizeType first, SizeType count, T * out) const
+            {
+                if (first > size() or count > size() - first) {
+                    throw std::out_of_range{"index out of range"};
+                }
+
+                data->decode(first, count, out);
+            }
+        };
+
+        // Helper functions for bitmaps which are stored as arrays of 64-bit words
+        inline std::size_t bitmap_word_count(std::size_t bits)
+        {
+            return (bits + 63) / 64;
+        }
+
+        inline bool test_bit(const std::uint64_t * bitmap, std::size_t index)
+        {
+            return (bitmap[index / 64] >> (index % 64)) & 1;
+        }
+
+        inline void set_bit(std::uint64_t * bitmap, std::size_t index)
+        {
+            bitmap[index / 64] |= std::uint64_t{1} << (index % 64);
+        }
+
+        inline std::size_t count_bits(const std::uint64_t * bitmap, std::size_t bits)
+        {
+            std::size_t result{0};
+            for (std::size_t word{0}; word < bitmap_word_count(bits); ++word) {
+                result += static_cast<std::size_t>(std::popcount(bitmap[word]));
+            }
+            return result;
+        }
+
+        // Data of a generic_optional_vector: a bitmap which tells which items have a value,
+        // followed by an array of all values. The values of empty items are zero. Compared to
+        // an array of std::optional<T>, this avoids the flag and the padding in each item.
+        template <typename T, typename SizeType>
+        struct generic_optional_vector_data
+        {
+            static_assert(alignof(T) <= alignof(std::uint64_t));
+
+            SizeType vector_length;
+            std::uint64_t validity[];
+
+            generic_optional_vector_data(const generic_optional_vector_data &) = delete;
+
+            generic_optional_vector_data(generic_optional_vector_data &&) = delete;
+
+            static std::size_t extra_bytes(std::size_t size)
+            {
+                return bitmap_word_count(size) * sizeof(std::uint64_t) + size * sizeof(T);
+            }
+
+            SizeType size() const
+            {
+                return vector_length;
+            }
+
+            bool has_value(SizeType index) const
+            {
+                return test_bit(validity, index);
+            }
+
+            const T * values() const
+            {
+                return reinterpret_cast<const T *>(validity + bitmap_word_count(vector_length));
+            }
+
+            T * values()
+            {
+                return reinterpret_cast<T *>(validity + bitmap_word_count(vector_length));
+            }
+
+            std::optional<T> operator[](SizeType index) const
+            {
+                if (has_value(index)) {
+                    return values()[index];
+                }
+                return std::nullopt;
+            }
+        };
+
+        // Data of a generic_optional_string_vector: a bitmap which tells which items have a
+        // value, followed by vector_length + 1 offsets and the characters of all strings. The
+        // characters of item i are in [offsets[i], offsets[i + 1]).
+        template <typename SizeType>
+        struct generic_optional_string_vector_data
+        {
+            SizeType vector_length;
+            std::uint64_t validity[];
+
+            generic_optional_string_vector_data(const generic_optional_string_vector_data &) =
+                delete;
+
+            generic_optional_string_vector_data(generic_optional_string_vector_data &&) = delete;
+
+            static std::size_t extra_bytes(std::size_t size, std::size_t characters)
+            {
+                return bitmap_word_count(size) * sizeof(std::uint64_t)
+                       + (size + 1) * sizeof(SizeType) + characters;
+            }
+
+            SizeType size() const
+            {
+                return vector_length;
+            }
+
+            bool has_value(SizeType index) const
+            {
+                return test_bit(validity, index);
+            }
+
+            const SizeType * offsets() const
+            {
+                return reinterpret_cast<const SizeType *>(
+                    validity + bitmap_word_count(vector_length));
+            }
+
+            SizeType * offsets()
+            {
+                return reinterpret_cast<SizeType *>(validity + bitmap_word_count(vector_length));
+            }
+
+            const char * characters() const
+            {
+                return reinterpret_cast<const char *>(offsets() + vector_length + 1);
+            }
+
+            char * characters()
+            {
+                return reinterpret_cast<char *>(offsets() + vector_length + 1);
+            }
+
+            std::optional<std::string_view> operator[](SizeType index) const
+            {
+                if (has_value(index)) {
+                    const SizeType * o{offsets()};
+                    return std::string_view{characters() + o[index], o[index + 1] - o[index]};
+                }
+                return std::nullopt;
+            }
+        };
+
+        // Data of a generic_string_vector: vector_length + 1 offsets, followed by the
+        // characters of all strings without separators. The characters of item i are in
+        // [offsets[i], offsets[i + 1]).
+        template <typename SizeType>
+        struct generic_string_vector_data
+        {
+            SizeType vector_length;
+            SizeType offsets[];
+
+            generic_string_vector_data(const generic_string_vector_data &) = delete;
+
+            generic_string_vector_data(generic_string_vector_data &&) = delete;
+
+            static std::size_t extra_bytes(std::size_t size, std::size_t characters)
+            {
+                return (size + 1) * sizeof(SizeType) + characters;
+            }
+
+            SizeType size() const
+            {
+                return vector_length;
+            }
+
+            const char * characters() const
+            {
+                return reinterpret_cast<const char *>(offsets + vector_length + 1);
+            }
+
+            char * characters()
+            {
+                return reinterpret_cast<char *>(offsets + vector_length + 1);
+            }
+
+            std::string_view operator[](SizeType index) const
+            {
+                return {characters() + offsets[index], offsets[index + 1] - offsets[index]};
+            }
+        };
+
+        // Vector of strings which are stored contiguously, see generic_string_vector_data.
+        // Iterating over the strings is a linear scan over the offsets and the characters.
+        template <typename OffsetType, typename SizeType>
+        struct generic_string_vector
+        {
+            using DataType = generic_string_vector_data<SizeType>;
+            using const_iterator = index_iterator<DataType>;
+            using iterator = const_iterator;
+
+        private:
+            template <typename> friend struct pid::type_layout;
+
+            ptr<DataType, OffsetType> data;
+
+        public:
+            auto & operator=(builder_offset<DataType> p)
+            {
+                p.assign_to(data);
+                return *this;
+            }
+
+            SizeType size() const
+            {
+                return data->size();
+            }
+
+            bool empty() const
+            {
+                return size() == 0;
+            }
+
+            [[nodiscard]] const_iterator begin() const
+            {
+                return {&*data, 0};
+            }
+
+            [[nodiscard]] const_iterator end() const
+            {
+                return {&*data, size()};
+            }
+
+            std::string_view operator[](SizeType index) const
+            {
+                return (*data)[index];
+            }
+
+            std::string_view at(SizeType index) const
+            {
+                if (index >= 0 and index < size()) {
+                    return (*data)[index];
+                } else {
+                    throw std::out_of_range{"index out of range"};
+                }
+            }
+        };
+        // Code of a generic_compressed_string_vector_data which is followed by a single
+        // character that is not covered by the symbol table
+        inline constexpr std::uint8_t symbol_escape_code{255};
+
+        // Encodes 's' with a table of 'count' symbols, which are stored in 8 bytes each and
+        // sorted by their first character and then by descending length. At each position,
+        // the longest matching symbol is used, so the encoding of a string is unique for a
+        // given table. Calls output(code) for each code and stops as soon as it returns false.
+        // Returns whether all codes have been accepted.
+        template <typename Output>
+        bool encode_with_symbols(
+            const char * symbols, const std::uint8_t * lengths, std::size_t count,
+            std::string_view s, Output output)
+        {
+            std::size_t position{0};
+            while (position < s.size()) {
+                const auto first{static_cast<unsigned char>(s[position])};
+
+                std::size_t low{0};
+                std::size_t high{count};
+                while (low < high) {
+                    const std::size_t middle{low + (high - low) / 2};
+                    if (static_cast<unsigned char>(symbols[middle * 8]) < first) {
+                        low = middle + 1;
+                    } else {
+                        high = middle;
+                    }
+                }
+
+                std::size_t length{0};
+                for (; low < count and static_cast<unsigned char>(symbols[low * 8]) == first;
+                     ++low) {
+                    if (lengths[low] <= s.size() - position
+                        and std::memcmp(symbols + low * 8, s.data() + position, lengths[low])
+                                == 0) {
+                        length = lengths[low];
+                        break;
+                    }
+                }
+
+                if (length != 0) {
+                    if (not output(static_cast<std::uint8_t>(low))) {
+                        return false;
+                    }
+                    position += length;
+                } else {
+                    if (not output(symbol_escape_code) or not output(first)) {
+                        return false;
+                    }
+                    ++position;
+                }
+            }
+            return true;
+        }
+
+        // Data of a generic_compressed_string_vector: vector_length + 1 offsets into the
+        // codes, a table of symbol_count symbols, their lengths, and the codes of all strings.
+        // The codes of item i are in [offsets[i], offsets[i + 1]). Each code is the index of
+        // a symbol of 1 to 8 characters, or symbol_escape_code followed by a literal
+        // character. The symbols are stored in 8 bytes each, padded with zeros, and sorted as
+        // required by encode_with_symbols().
+        template <typename SizeType>
+        struct generic_compressed_string_vector_data
+        {
+            static constexpr std::size_t max_symbols{255};
+            static constexpr std::size_t max_symbol_length{8};
+
+            SizeType vector_length;
+            SizeType symbol_count;
+            SizeType offsets[];
+
+            generic_compressed_string_vector_data(const generic_compressed_string_vector_data &) =
+                delete;
+
+            generic_compressed_string_vector_data(generic_compressed_string_vector_data &&) =
+                delete;
+
+            static std::size_t extra_bytes(
+                std::size_t size, std::size_t symbols, std::size_t codes)
+            {
+                return (size + 1) * sizeof(SizeType) + symbols * (max_symbol_length + 1) + codes;
+            }
+
+            SizeType size() const
+            {
+                return vector_length;
+            }
+
+            const char * symbols() const
+            {
+                return reinterpret_cast<const char *>(offsets + vector_length + 1);
+            }
+
+            char * symbols()
+            {
+                return reinterpret_cast<char *>(offsets + vector_length + 1);
+            }
+
+            const std::uint8_t * symbol_lengths() const
+            {
+                return reinterpret_cast<const std::uint8_t *>(
+                    symbols() + std::size_t{symbol_count} * max_symbol_length);
+            }
+
+            std::uint8_t * symbol_lengths()
+            {
+                return reinterpret_cast<std::uint8_t *>(
+                    symbols() + std::size_t{symbol_count} * max_symbol_length);
+            }
+
+            const char * codes() const
+            {
+                return reinterpret_cast<const char *>(symbol_lengths() + symbol_count);
+            }
+
+            char * codes()
+            {
+                return reinterpret_cast<char *>(symbol_lengths() + symbol_count);
+            }
+
+            std::string_view compressed(SizeType index) const
+            {
+                return {codes() + offsets[index], offsets[index + 1] - offsets[index]};
+            }
+
+            template <typename Output>
+            bool encode(std::string_view s, Output output) const
+            {
+                return encode_with_symbols(symbols(), symbol_lengths(), symbol_count, s, output);
+            }
+        };
+
+        // Vector of strings which are compressed with a symbol table that is stored once for
+        // all of them, see generic_compressed_string_vector_data. Each string can be
+        // decompressed on its own. Since the encoding of a string is unique, strings can be
+        // compared for equality without decompressing them. verify() checks that the codes are
+        // this encoding.
+        template <typename OffsetType, typename SizeType>
+        struct generic_compressed_string_vector
+        {
+            using DataType = generic_compressed_string_vector_data<SizeType>;
+
+        private:
+            template <typename> friend struct pid::type_layout;
+
+            ptr<DataType, OffsetType> data;
+
+        public:
+            generic_compressed_string_vector(const generic_compressed_string_vector &) = delete;
+
+            generic_compressed_string_vector(generic_compressed_string_vector &&) = delete;
+
+            generic_compressed_string_vector(builder_offset<DataType> p)
+            {
+                *this = p;
+            }
+
+            auto & operator=(builder_offset<DataType> p)
+            {
+                p.assign_to(data);
+                return *this;
+            }
+
+            SizeType size() const
+            {
+                return data->size();
+            }
+
+            bool empty() const
+            {
+                return size() == 0;
+            }
+
+            // Returns the codes of a string
+            std::string_view compressed(SizeType index) const
+            {
+                return data->compressed(index);
+            }
+
+            // Returns the size of a buffer which is large enough for decompress()
+            std::size_t max_decompressed_size(SizeType index) const
+            {
+                return compressed(index).size() * DataType::max_symbol_length;
+            }
+
+            // Decompresses a string into 'buffer' and returns it. Throws std::length_error if
+            // the buffer is too small.
+            std::string_view decompress(SizeType index, std::span<char> buffer) const
+            {
+                const DataType & d{*data};
+                const std::string_view codes{d.compressed(index)};
+                const char * const symbols{d.symbols()};
+                const std::uint8_t * const lengths{d.symbol_lengths()};
+
+                char * output{buffer.data()};
+                char * const output_end{buffer.data() + buffer.size()};
+                for (std::size_t i{0}; i < codes.size(); ++i) {
+                    const auto code{static_cast<std::uint8_t>(codes[i])};
+                    if (code == symbol_escape_code) {
+                        if (output == output_end) {
+                            throw std::length_error{"buffer is too small for the string"};
+                        }
+                        *output++ = codes[++i];
+                        continue;
+                    }
+
+                    // Copying whole symbols is faster than copying their exact lengths
+                    const char * const symbol{symbols + std::size_t{code} * 8};
+                    const std::size_t length{lengths[code]};
+                    if (output_end - output >= 8) {
+                        std::memcpy(output, symbol, 8);
+                    } else if (static_cast<std::size_t>(output_end - output) >= length) {
+                        std::memcpy(output, symbol, length);
+                    } else {
+                        throw std::length_error{"buffer is too small for the string"};
+                    }
+                    output += length;
+                }
+
+                return {buffer.data(), static_cast<std::size_t>(output - buffer.data())};
+            }
+
+            std::string operator[](SizeType index) const
+            {
+                std::string result(max_decompressed_size(index), '\0');
+                result.resize(decompress(index, result).size());
+                return result;
+            }
+
+            std::string at(SizeType index) const
+            {
+                if (index >= 0 and index < size()) {
+                    return (*this)[index];
+                } else {
+                    throw std::out_of_range{"index out of range"};
+                }
+            }
+
+            // Compares two strings of this vector without decompressing them
+            bool equal(SizeType index, SizeType other_index) const
+            {
+                return compressed(index) == compressed(other_index);
+            }
+
+            // Compares a string of this vector with 's' by encoding 's' with the same table
+            bool equal(SizeType index, std::string_view s) const
+            {
+                const std::string_view codes{compressed(index)};
+                std::size_t position{0};
+                return data->encode(
+                           s,
+                           [&](std::uint8_t code) {
+                               return position < codes.size()
+                                   and static_cast<std::uint8_t>(codes[position++]) == code;
+                           })
+                    and position == codes.size();
+            }
+        };
+
+
+        // Vector of optional values, which are stored in a DataType like
+        // generic_optional_vector_data. The items are returned by value.
+        template <typename DataType, typename OffsetType, typename SizeType>
+        struct generic_bitmap_vector
+        {
+            using const_iterator = index_iterator<DataType>;
+            using iterator = const_iterator;
+            using value_type = typename const_iterator::value_type;
+
+        private:
+            template <typename> friend struct pid::type_layout;
+
+            ptr<DataType, OffsetType> data;
+
+        public:
+            auto & operator=(builder_offset<DataType> p)
+            {
+                p.assign_to(data);
+                return *this;
+            }
+
+            SizeType size() const
+            {
+                return data->size();
+            }
+
+            bool empty() const
+            {
+                return size() == 0;
+            }
+
+            bool has_value(SizeType index) const
+            {
+                return data->has_value(index);
+            }
+
+            // Number of items which have a value
+            SizeType value_count() const
+            {
+                return static_cast<SizeType>(count_bits(data->validity, size()));
+            }
+
+            [[nodiscard]] const_iterator begin() const
+            {
+                return {&*data, 0};
+            }
+
+            [[nodiscard]] const_iterator end() const
+            {
+                return {&*data, size()};
+            }
+
+            value_type operator[](SizeType index) const
+            {
+                return (*data)[index];
+            }
+
+            value_type at(SizeType index) const
+            {
+                if (index >= 0 and index < size()) {
+                    return (*data)[index];
+                } else {
+                    throw std::out_of_range{"index out of range"};
+                }
+            }
+        };
+
+        template <typename T, typename OffsetType, typename SizeType>
+        using generic_optional_vector = generic_bitmap_vector<
+            generic_optional_vector_data<T, SizeType>, OffsetType, SizeType>;
+
+        template <typename OffsetType, typename SizeType>
+        using generic_optional_string_vector = generic_bitmap_vector<
+            generic_optional_string_vector_data<SizeType>, OffsetType, SizeType>;
+
+        template <typename Key, typename Value>
+        using map32 = generic_map<Key, Value, std::int32_t, std::uint32_t>;
+    }
+}
+
+namespace pid8 {
+    template <typename T>
+    using ptr = pid::detail::ptr<T, std::int8_t>;
+
+    using string8 = pid::detail::generic_string<std::int8_t, std::uint8_t>;
+    using string16 = pid::detail::generic_string<std::int8_t, std::uint16_t>;
+    using string32 = pid::detail::generic_string<std::int8_t, std::uint32_t>;
+    using string64 = pid::detail::generic_string<std::int8_t, std::uint64_t>;
+
+    using prefix_string = pid::detail::generic_prefix_string<std::int8_t>;
+
+    using hashed_string8 = pid::detail::generic_hashed_string<std::int8_t, std::uint8_t>;
+    using hashed_string16 = pid::detail::generic_hashed_string<std::int8_t, std::uint16_t>;
+    using hashed_string32 = pid::detail::generic_hashed_string<std::int8_t, std::uint32_t>;
+    using hashed_string64 = pid::detail::generic_hashed_string<std::int8_t, std::uint64_t>;
+
+    template <typename T>
+    using vector8 = pid::detail::generic_vector<T, std::int8_t, std::uint8_t>;
+
+    template <typename T>
+    using vector16 = pid::detail::generic_vector<T, std::int8_t, std::uint16_t>;
+
+    template <typename T>
+    using vector32 = pid::detail::generic_vector<T, std::int8_t, std::uint32_t>;
+
+    template <typename T>
+    using vector64 = pid::detail::generic_vector<T, std::int8_t, std::uint64_t>;
+
+    template <typename T>
+    using packed_vector8 = pid::detail::generic_packed_vector<T, std::int8_t, std::uint8_t>;
+
+    template <typename T>
+    using packed_vector16 = pid::detail::generic_packed_vector<T, std::int8_t, std::uint16_t>;
+
+    template <typename T>
+    using packed_vector32 = pid::detail::generic_packed_vector<T, std::int8_t, std::uint32_t>;
+
+    template <typename T>
+    using packed_vector64 = pid::detail::generic_packed_vector<T, std::int8_t, std::uint64_t>;
+
+    template <typename T>
+    using optional_vector8 = pid::detail::generic_optional_vector<T, std::int8_t, std::uint8_t>;
+
+    template <typename T>
+    using optional_vector16 = pid::detail::generic_optional_vector<T, std::int8_t, std::uint16_t>;
+
+    template <typename T>
+    using optional_vector32 = pid::detail::generic_optional_vector<T, std::int8_t, std::uint32_t>;
+
+    template <typename T>
+    using optional_vector64 = pid::detail::generic_optional_vector<T, std::int8_t, std::uint64_t>;
+
+    using optional_string_vector8 =
+        pid::detail::generic_optional_string_vector<std::int8_t, std::uint8_t>;
+
+    using optional_string_vector16 =
+        pid::detail::generic_optional_string_vector<std::int8_t, std::uint16_t>;
+
+    using optional_string_vector32 =
+        pid::detail::generic_optional_string_vector<std::int8_t, std::uint32_t>;
+
+    using optional_string_vector64 =
+        pid::detail::generic_optional_string_vector<std::int8_t, std::uint64_t>;
+
+    using string_vector8 = pid::detail::generic_string_vector<std::int8_t, std::uint8_t>;
+
+    using string_vector16 = pid::detail::generic_string_vector<std::int8_t, std::uint16_t>;
+
+    using string_vector32 = pid::detail::generic_string_vector<std::int8_t, std::uint32_t>;
+
+    using string_vector64 = pid::detail::generic_string_vector<std::int8_t, std::uint64_t>;
+
+    using compressed_string_vector8 =
+        pid::detail::generic_compressed_string_vector<std::int8_t, std::uint8_t>;
+
+    using compressed_string_vector16 =
+        pid::detail::generic_compressed_string_vector<std::int8_t, std::uint16_t>;
+
+    using compressed_string_vector32 =
+        pid::detail::generic_compressed_string_vector<std::int8_t, std::uint32_t>;
+
+    using compressed_string_vector64 =
+        pid::detail::generic_compressed_string_vector<std::int8_t, std::uint64_t>;
+
+    template <typename Key, typename Value>
+    using map8 = pid::detail::generic_map<Key, Value, std::int8_t, std::uint8_t>;
+
+    template <typename Key, typename Value>
+    using map16 = pid::detail::generic_map<Key, Value, std::int8_t, std::uint16_t>;
+
+    template <typename Key, typename Value>
+    using map32 = pid::detail::generic_map<Key, Value, std::int8_t, std::uint32_t>;
+
+    template <typename Key, typename Value>
+    using map64 = pid::detail::generic_map<Key, Value, std::int8_t, std::uint64_t>;
+
+    template <typename Key, typename Value>
+    using eytzinger_map8 =
+        pid::detail::generic_eytzinger_map<Key, Value, std::int8_t, std::uint8_t>;
+
+    template <typename Key, typename Value>
+    using eytzinger_map16 =
+        pid::detail::generic_eytzinger_map<Key, Value, std::int8_t, std::uint16_t>;
+
+    template <typename Key, typename Value>
+    using eytzinger_map32 =
+        pid::detail::generic_eytzinger_map<Key, Value, std::int8_t, std::uint32_t>;
+
+    template <typename Key, typename Value>
+    using eytzinger_map64 =
+        pid::detail::generic_eytzinger_map<Key, Value, std::int8_t, std::uint64_t>;
+
+    template <typename Key, typename Value>
+    using hash_map8 = pid::detail::generic_hash_map<Key, Value, std::int8_t, std::uint8_t>;
+
+    template <typename Key, typename Value>
+    using hash_map16 = pid::detail::generic_hash_map<Key, Value, std::int8_t, std::uint16_t>;
+
+    template <typename Key, typename Value>
+    using hash_map32 = pid::detail::generic_hash_map<Key, Value, std::int8_t, std::uint32_t>;
+
+    template <typename Key, typename Value>
+    using hash_map64 = pid::detail::generic_hash_map<Key, Value, std::int8_t, std::uint64_t>;
+
+    template <typename Key, typename Value>
+    using soa_map8 = pid::detail::generic_soa_map<Key, Value, std::int8_t, std::uint8_t>;
+
+    template <typename Key, typename Value>
+    using soa_map16 = pid::detail::generic_soa_map<Key, Value, std::int8_t, std::uint16_t>;
+
+    template <typename Key, typename Value>
+    using soa_map32 = pid::detail::generic_soa_map<Key, Value, std::int8_t, std::uint32_t>;
+
+    template <typename Key, typename Value>
+    using soa_map64 = pid::detail::generic_soa_map<Key, Value, std::int8_t, std::uint64_t>;
+
+    template <typename Key, typename Value>
+    using s_tree_map8 = pid::detail::generic_s_tree_map<Key, Value, std::int8_t, std::uint8_t>;
+
+    template <typename Key, typename Value>
+    using s_tree_map16 = pid::detail::generic_s_tree_map<Key, Value, std::int8_t, std::uint16_t>;
+
+    template <typename Key, typename Value>
+    using s_tree_map32 = pid::detail::generic_s_tree_map<Key, Value, std::int8_t, std::uint32_t>;
+
+    template <typename Key, typename Value>
+    using s_tree_map64 = pid::detail::generic_s_tree_map<Key, Value, std::int8_t, std::uint64_t>;
+}
+
+namespace pid16 {
+    template <typename T>
+    using ptr = pid::detail::ptr<T, std::int16_t>;
+
+    using string8 = pid::detail::generic_string<std::int16_t, std::uint8_t>;
+    using string16 = pid::detail::generic_string<std::int16_t, std::uint16_t>;
+    using string32 = pid::detail::generic_string<std::int16_t, std::uint32_t>;
+    using string64 = pid::detail::generic_string<std::int16_t, std::uint64_t>;
+
+    using prefix_string = pid::detail::generic_prefix_string<std::int16_t>;
+
+    using hashed_string8 = pid::detail::generic_hashed_string<std::int16_t, std::uint8_t>;
+    using hashed_string16 = pid::detail::generic_hashed_string<std::int16_t, std::uint16_t>;
+    using hashed_string32 = pid::detail::generic_hashed_string<std::int16_t, std::uint32_t>;
+    using hashed_string64 = pid::detail::generic_hashed_string<std::int16_t, std::uint64_t>;
+
+    template <typename T>
+    using vector8 = pid::detail::generic_vector<T, std::int16_t, std::uint8_t>;
+
+    template <typename T>
+    using vector16 = pid::detail::generic_vector<T, std::int16_t, std::uint16_t>;
+
+    template <typename T>
+    using vector32 = pid::detail::generic_vector<T, std::int16_t, std::uint32_t>;
+
+    template <typename T>
+    using vector64 = pid::detail::generic_vector<T, std::int16_t, std::uint64_t>;
+
+    template <typename T>
+    using packed_vector8 = pid::detail::generic_packed_vector<T, std::int16_t, std::uint8_t>;
+
+    template <typename T>
+    using packed_vector16 = pid::detail::generic_packed_vector<T, std::int16_t, std::uint16_t>;
+
+    template <typename T>
+    using packed_vector32 = pid::detail::generic_packed_vector<T, std::int16_t, std::uint32_t>;
+
+    template <typename T>
+    using packed_vector64 = pid::detail::generic_packed_vector<T, std::int16_t, std::uint64_t>;
+
+    template <typename T>
+    using optional_vector8 = pid::detail::generic_optional_vector<T, std::int16_t, std::uint8_t>;
+
+    template <typename T>
+    using optional_vector16 = pid::detail::generic_optional_vector<T, std::int16_t, std::uint16_t>;
+
+    template <typename T>
+    using optional_vector32 = pid::detail::generic_optional_vector<T, std::int16_t, std::uint32_t>;
+
+    template <typename T>
+    using optional_vector64 = pid::detail::generic_optional_vector<T, std::int16_t, std::uint64_t>;
+
+    using optional_string_vector8 =
+        pid::detail::generic_optional_string_vector<std::int16_t, std::uint8_t>;
+
+    using optional_string_vector16 =
+        pid::detail::generic_optional_string_vector<std::int16_t, std::uint16_t>;
+
+    using optional_string_vector32 =
+        pid::detail::generic_optional_string_vector<std::int16_t, std::uint32_t>;
+
+    using optional_string_vector64 =
+        pid::detail::generic_optional_string_vector<std::int16_t, std::uint64_t>;
+
+    using string_vector8 = pid::detail::generic_string_vector<std::int16_t, std::uint8_t>;
+
+    using string_vector16 = pid::detail::generic_string_vector<std::int16_t, std::uint16_t>;
+
+    using string_vector32 = pid::detail::generic_string_vector<std::int16_t, std::uint32_t>;
+
+    using string_vector64 = pid::detail::generic_string_vector<std::int16_t, std::uint64_t>;
+
+    using compressed_string_vector8 =
+        pid::detail::generic_compressed_string_vector<std::int16_t, std::uint8_t>;
+
+    using compressed_string_vector16 =
+        pid::detail::generic_compressed_string_vector<std::int16_t, std::uint16_t>;
+
+    using compressed_string_vector32 =
+        pid::detail::generic_compressed_string_vector<std::int16_t, std::uint32_t>;
+
+    using compressed_string_vector64 =
+        pid::detail::generic_compressed_string_vector<std::int16_t, std::uint64_t>;
+
+    template <typename Key, typename Value>
+    using map8 = pid::detail::generic_map<Key, Value, std::int16_t, std::uint8_t>;
+
+    template <typename Key, typename Value>
+    using map16 = pid::detail::generic_map<Key, Value, std::int16_t, std::uint16_t>;
+
+    template <typename Key, typename Value>
+    using map32 = pid::detail::generic_map<Key, Value, std::int16_t, std::uint32_t>;
+
+    template <typename Key, typename Value>
+    using map64 = pid::detail::generic_map<Key, Value, std::int16_t, std::uint64_t>;
+
+    template <typename Key, typename Value>
+    using eytzinger_map8 =
+        pid::detail::generic_eytzinger_map<Key, Value, std::int16_t, std::uint8_t>;
+
+    template <typename Key, typename Value>
+    using eytzinger_map16 =
+        pid::detail::generic_eytzinger_map<Key, Value, std::int16_t, std::uint16_t>;
+
+    template <typename Key, typename Value>
+    using eytzinger_map32 =
+        pid::detail::generic_eytzinger_map<Key, Value, std::int16_t, std::uint32_t>;
+
+    template <typename Key, typename Value>
+    using eytzinger_map64 =
+        pid::detail::generic_eytzinger_map<Key, Value, std::int16_t, std::uint64_t>;
+
+    template <typename Key, typename Value>
+    using hash_map8 = pid::detail::generic_hash_map<Key, Value, std::int16_t, std::uint8_t>;
+
+    template <typename Key, typename Value>
+    using hash_map16 = pid::detail::generic_hash_map<Key, Value, std::int16_t, std::uint16_t>;
+
+    template <typename Key, typename Value>
+    using hash_map32 = pid::detail::generic_hash_map<Key, Value, std::int16_t, std::uint32_t>;
+
+    template <typename Key, typename Value>
+    using hash_map64 = pid::detail::generic_hash_map<Key, Value, std::int16_t, std::uint64_t>;
+
+    template <typename Key, typename Value>
+    using soa_map8 = pid::detail::generic_soa_map<Key, Value, std::int16_t, std::uint8_t>;
+
+    template <typename Key, typename Value>
+    using soa_map16 = pid::detail::generic_soa_map<Key, Value, std::int16_t, std::uint16_t>;
+
+    template <typename Key, typename Value>
+    using soa_map32 = pid::detail::generic_soa_map<Key, Value, std::int16_t, std::uint32_t>;
+
+    template <typename Key, typename Value>
+    using soa_map64 = pid::detail::generic_soa_map<Key, Value, std::int16_t, std::uint64_t>;
+
+    template <typename Key, typename Value>
+    using s_tree_map8 = pid::detail::generic_s_tree_map<Key, Value, std::int16_t, std::uint8_t>;
+
+    template <typename Key, typename Value>
+    using s_tree_map16 = pid::detail::generic_s_tree_map<Key, Value, std::int16_t, std::uint16_t>;
+
+    template <typename Key, typename Value>
+    using s_tree_map32 = pid::detail::generic_s_tree_map<Key, Value, std::int16_t, std::uint32_t>;
+
+    template <typename Key, typename Value>
+    using s_tree_map64 = pid::detail::generic_s_tree_map<Key, Value, std::int16_t, std::uint64_t>;
+}
+
+namespace pid32 {
+    template <typename T>
+    using ptr = pid::detail::ptr<T, std::int32_t>;
+
+    using string8 = pid::detail::generic_string<std::int32_t, std::uint8_t>;
+    using string16 = pid::detail::generic_string<std::int32_t, std::uint16_t>;
+    using string32 = pid::detail::generic_string<std::int32_t, std::uint32_t>;
+    using string64 = pid::detail::generic_string<std::int32_t, std::uint64_t>;
+
+    using prefix_string = pid::detail::generic_prefix_string<std::int32_t>;
+
+    using hashed_string8 = pid::detail::generic_hashed_string<std::int32_t, std::uint8_t>;
+    using hashed_string16 = pid::detail::generic_hashed_string<std::int32_t, std::uint16_t>;
+    using hashed_string32 = pid::detail::generic_hashed_string<std::int32_t, std::uint32_t>;
+    using hashed_string64 = pid::detail::generic_hashed_string<std::int32_t, std::uint64_t>;
+
+    template <typename T>
+    using vector8 = pid::detail::generic_vector<T, std::int32_t, std::uint8_t>;
 
     template <typename T>
     using vector16 = pid::detail::generic_vector<T, std::int32_t, std::uint16_t>;
@@ -455,6 +2842,62 @@ namespace pid32 {
     template <typename T>
     using vector64 = pid::detail::generic_vector<T, std::int32_t, std::uint64_t>;
 
+    template <typename T>
+    using packed_vector8 = pid::detail::generic_packed_vector<T, std::int32_t, std::uint8_t>;
+
+    template <typename T>
+    using packed_vector16 = pid::detail::generic_packed_vector<T, std::int32_t, std::uint16_t>;
+
+    template <typename T>
+    using packed_vector32 = pid::detail::generic_packed_vector<T, std::int32_t, std::uint32_t>;
+
+    template <typename T>
+    using packed_vector64 = pid::detail::generic_packed_vector<T, std::int32_t, std::uint64_t>;
+
+    template <typename T>
+    using optional_vector8 = pid::detail::generic_optional_vector<T, std::int32_t, std::uint8_t>;
+
+    template <typename T>
+    using optional_vector16 = pid::detail::generic_optional_vector<T, std::int32_t, std::uint16_t>;
+
+    template <typename T>
+    using optional_vector32 = pid::detail::generic_optional_vector<T, std::int32_t, std::uint32_t>;
+
+    template <typename T>
+    using optional_vector64 = pid::detail::generic_optional_vector<T, std::int32_t, std::uint64_t>;
+
+    using optional_string_vector8 =
+        pid::detail::generic_optional_string_vector<std::int32_t, std::uint8_t>;
+
+    using optional_string_vector16 =
+        pid::detail::generic_optional_string_vector<std::int32_t, std::uint16_t>;
+
+    using optional_string_vector32 =
+        pid::detail::generic_optional_string_vector<std::int32_t, std::uint32_t>;
+
+    using optional_string_vector64 =
+        pid::detail::generic_optional_string_vector<std::int32_t, std::uint64_t>;
+
+    using string_vector8 = pid::detail::generic_string_vector<std::int32_t, std::uint8_t>;
+
+    using string_vector16 = pid::detail::generic_string_vector<std::int32_t, std::uint16_t>;
+
+    using string_vector32 = pid::detail::generic_string_vector<std::int32_t, std::uint32_t>;
+
+    using string_vector64 = pid::detail::generic_string_vector<std::int32_t, std::uint64_t>;
+
+    using compressed_string_vector8 =
+        pid::detail::generic_compressed_string_vector<std::int32_t, std::uint8_t>;
+
+    using compressed_string_vector16 =
+        pid::detail::generic_compressed_string_vector<std::int32_t, std::uint16_t>;
+
+    using compressed_string_vector32 =
+        pid::detail::generic_compressed_string_vector<std::int32_t, std::uint32_t>;
+
+    using compressed_string_vector64 =
+        pid::detail::generic_compressed_string_vector<std::int32_t, std::uint64_t>;
+
     template <typename Key, typename Value>
     using map8 = pid::detail::generic_map<Key, Value, std::int32_t, std::uint8_t>;
 
@@ -466,6 +2909,58 @@ namespace pid32 {
 
     template <typename Key, typename Value>
     using map64 = pid::detail::generic_map<Key, Value, std::int32_t, std::uint64_t>;
+
+    template <typename Key, typename Value>
+    using eytzinger_map8 =
+        pid::detail::generic_eytzinger_map<Key, Value, std::int32_t, std::uint8_t>;
+
+    template <typename Key, typename Value>
+    using eytzinger_map16 =
+        pid::detail::generic_eytzinger_map<Key, Value, std::int32_t, std::uint16_t>;
+
+    template <typename Key, typename Value>
+    using eytzinger_map32 =
+        pid::detail::generic_eytzinger_map<Key, Value, std::int32_t, std::uint32_t>;
+
+    template <typename Key, typename Value>
+    using eytzinger_map64 =
+        pid::detail::generic_eytzinger_map<Key, Value, std::int32_t, std::uint64_t>;
+
+    template <typename Key, typename Value>
+    using hash_map8 = pid::detail::generic_hash_map<Key, Value, std::int32_t, std::uint8_t>;
+
+    template <typename Key, typename Value>
+    using hash_map16 = pid::detail::generic_hash_map<Key, Value, std::int32_t, std::uint16_t>;
+
+    template <typename Key, typename Value>
+    using hash_map32 = pid::detail::generic_hash_map<Key, Value, std::int32_t, std::uint32_t>;
+
+    template <typename Key, typename Value>
+    using hash_map64 = pid::detail::generic_hash_map<Key, Value, std::int32_t, std::uint64_t>;
+
+    template <typename Key, typename Value>
+    using soa_map8 = pid::detail::generic_soa_map<Key, Value, std::int32_t, std::uint8_t>;
+
+    template <typename Key, typename Value>
+    using soa_map16 = pid::detail::generic_soa_map<Key, Value, std::int32_t, std::uint16_t>;
+
+    template <typename Key, typename Value>
+    using soa_map32 = pid::detail::generic_soa_map<Key, Value, std::int32_t, std::uint32_t>;
+
+    template <typename Key, typename Value>
+    using soa_map64 = pid::detail::generic_soa_map<Key, Value, std::int32_t, std::uint64_t>;
+
+    template <typename Key, typename Value>
+    using s_tree_map8 = pid::detail::generic_s_tree_map<Key, Value, std::int32_t, std::uint8_t>;
+
+    template <typename Key, typename Value>
+    using s_tree_map16 = pid::detail::generic_s_tree_map<Key, Value, std::int32_t, std::uint16_t>;
+
+    template <typename Key, typename Value>
+    using s_tree_map32 = pid::detail::generic_s_tree_map<Key, Value, std::int32_t, std::uint32_t>;
+
+    template <typename Key, typename Value>
+    using s_tree_map64 = pid::detail::generic_s_tree_map<Key, Value, std::int32_t, std::uint64_t>;
 }
 
 namespace pid64 {
@@ -477,6 +2972,13 @@ namespace pid64 {
     using string32 = pid::detail::generic_string<std::int64_t, std::uint32_t>;
     using string64 = pid::detail::generic_string<std::int64_t, std::uint64_t>;
 
+    using prefix_string = pid::detail::generic_prefix_string<std::int64_t>;
+
+    using hashed_string8 = pid::detail::generic_hashed_string<std::int64_t, std::uint8_t>;
+    using hashed_string16 = pid::detail::generic_hashed_string<std::int64_t, std::uint16_t>;
+    using hashed_string32 = pid::detail::generic_hashed_string<std::int64_t, std::uint32_t>;
+    using hashed_string64 = pid::detail::generic_hashed_string<std::int64_t, std::uint64_t>;
+
     template <typename T>
     using vector8 = pid::detail::generic_vector<T, std::int64_t, std::uint8_t>;
 
@@ -489,6 +2991,62 @@ namespace pid64 {
     template <typename T>
     using vector64 = pid::detail::generic_vector<T, std::int64_t, std::uint64_t>;
 
+    template <typename T>
+    using packed_vector8 = pid::detail::generic_packed_vector<T, std::int64_t, std::uint8_t>;
+
+    template <typename T>
+    using packed_vector16 = pid::detail::generic_packed_vector<T, std::int64_t, std::uint16_t>;
+
+    template <typename T>
+    using packed_vector32 = pid::detail::generic_packed_vector<T, std::int64_t, std::uint32_t>;
+
+    template <typename T>
+    using packed_vector64 = pid::detail::generic_packed_vector<T, std::int64_t, std::uint64_t>;
+
+    template <typename T>
+    using optional_vector8 = pid::detail::generic_optional_vector<T, std::int64_t, std::uint8_t>;
+
+    template <typename T>
+    using optional_vector16 = pid::detail::generic_optional_vector<T, std::int64_t, std::uint16_t>;
+
+    template <typename T>
+    using optional_vector32 = pid::detail::generic_optional_vector<T, std::int64_t, std::uint32_t>;
+
+    template <typename T>
+    using optional_vector64 = pid::detail::generic_optional_vector<T, std::int64_t, std::uint64_t>;
+
+    using optional_string_vector8 =
+        pid::detail::generic_optional_string_vector<std::int64_t, std::uint8_t>;
+
+    using optional_string_vector16 =
+        pid::detail::generic_optional_string_vector<std::int64_t, std::uint16_t>;
+
+    using optional_string_vector32 =
+        pid::detail::generic_optional_string_vector<std::int64_t, std::uint32_t>;
+
+    using optional_string_vector64 =
+        pid::detail::generic_optional_string_vector<std::int64_t, std::uint64_t>;
+
+    using string_vector8 = pid::detail::generic_string_vector<std::int64_t, std::uint8_t>;
+
+    using string_vector16 = pid::detail::generic_string_vector<std::int64_t, std::uint16_t>;
+
+    using string_vector32 = pid::detail::generic_string_vector<std::int64_t, std::uint32_t>;
+
+    using string_vector64 = pid::detail::generic_string_vector<std::int64_t, std::uint64_t>;
+
+    using compressed_string_vector8 =
+        pid::detail::generic_compressed_string_vector<std::int64_t, std::uint8_t>;
+
+    using compressed_string_vector16 =
+        pid::detail::generic_compressed_string_vector<std::int64_t, std::uint16_t>;
+
+    using compressed_string_vector32 =
+        pid::detail::generic_compressed_string_vector<std::int64_t, std::uint32_t>;
+
+    using compressed_string_vector64 =
+        pid::detail::generic_compressed_string_vector<std::int64_t, std::uint64_t>;
+
     template <typename Key, typename Value>
     using map8 = pid::detail::generic_map<Key, Value, std::int64_t, std::uint8_t>;
 
@@ -500,6 +3058,58 @@ namespace pid64 {
 
     template <typename Key, typename Value>
     using map64 = pid::detail::generic_map<Key, Value, std::int64_t, std::uint64_t>;
+
+    template <typename Key, typename Value>
+    using eytzinger_map8 =
+        pid::detail::generic_eytzinger_map<Key, Value, std::int64_t, std::uint8_t>;
+
+    template <typename Key, typename Value>
+    using eytzinger_map16 =
+        pid::detail::generic_eytzinger_map<Key, Value, std::int64_t, std::uint16_t>;
+
+    template <typename Key, typename Value>
+    using eytzinger_map32 =
+        pid::detail::generic_eytzinger_map<Key, Value, std::int64_t, std::uint32_t>;
+
+    template <typename Key, typename Value>
+    using eytzinger_map64 =
+        pid::detail::generic_eytzinger_map<Key, Value, std::int64_t, std::uint64_t>;
+
+    template <typename Key, typename Value>
+    using hash_map8 = pid::detail::generic_hash_map<Key, Value, std::int64_t, std::uint8_t>;
+
+    template <typename Key, typename Value>
+    using hash_map16 = pid::detail::generic_hash_map<Key, Value, std::int64_t, std::uint16_t>;
+
+    template <typename Key, typename Value>
+    using hash_map32 = pid::detail::generic_hash_map<Key, Value, std::int64_t, std::uint32_t>;
+
+    template <typename Key, typename Value>
+    using hash_map64 = pid::detail::generic_hash_map<Key, Value, std::int64_t, std::uint64_t>;
+
+    template <typename Key, typename Value>
+    using soa_map8 = pid::detail::generic_soa_map<Key, Value, std::int64_t, std::uint8_t>;
+
+    template <typename Key, typename Value>
+    using soa_map16 = pid::detail::generic_soa_map<Key, Value, std::int64_t, std::uint16_t>;
+
+    template <typename Key, typename Value>
+    using soa_map32 = pid::detail::generic_soa_map<Key, Value, std::int64_t, std::uint32_t>;
+
+    template <typename Key, typename Value>
+    using soa_map64 = pid::detail::generic_soa_map<Key, Value, std::int64_t, std::uint64_t>;
+
+    template <typename Key, typename Value>
+    using s_tree_map8 = pid::detail::generic_s_tree_map<Key, Value, std::int64_t, std::uint8_t>;
+
+    template <typename Key, typename Value>
+    using s_tree_map16 = pid::detail::generic_s_tree_map<Key, Value, std::int64_t, std::uint16_t>;
+
+    template <typename Key, typename Value>
+    using s_tree_map32 = pid::detail::generic_s_tree_map<Key, Value, std::int64_t, std::uint32_t>;
+
+    template <typename Key, typename Value>
+    using s_tree_map64 = pid::detail::generic_s_tree_map<Key, Value, std::int64_t, std::uint64_t>;
 }
 
 namespace pid {
@@ -509,9 +3119,37 @@ namespace pid {
 
     using string = pid32::string32;
 
+    using prefix_string = pid32::prefix_string;
+
+    using hashed_string = pid32::hashed_string32;
+
     template <typename T>
     using vector = pid32::vector32<T>;
 
+    template <typename T>
+    using packed_vector = pid32::packed_vector32<T>;
+
+    template <typename T>
+    using optional_vector = pid32::optional_vector32<T>;
+
+    using optional_string_vector = pid32::optional_string_vector32;
+
+    using string_vector = pid32::string_vector32;
+
+    using compressed_string_vector = pid32::compressed_string_vector32;
+
     template <typename Key, typename Value>
     using map = pid32::map32<Key, Value>;
+
+    template <typename Key, typename Value>
+    using eytzinger_map = pid32::eytzinger_map32<Key, Value>;
+
+    template <typename Key, typename Value>
+    using hash_map = pid32::hash_map32<Key, Value>;
+
+    template <typename Key, typename Value>
+    using soa_map = pid32::soa_map32<Key, Value>;
+
+    template <typename Key, typename Value>
+    using s_tree_map = pid32::s_tree_map32<Key, Value>;
 }
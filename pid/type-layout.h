@@ -0,0 +1,899 @@
+#pragma once
+
+#include "pid.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Describes where the relative pointers are in the types which are stored in blobs. This makes
+// it possible to traverse all objects which are reachable from a root object without knowing
+// their types at compile time, e.g., to verify a blob that was loaded from a file.
+
+namespace pid {
+    struct object_type;
+
+    // Receives the pointers and the consistency checks of the values which are visited with
+    // type_layout<T>::visit().
+    struct layout_visitor
+    {
+        // Called for each relative pointer. 'field' is the address of the pointer, which stores
+        // 'offset' in 'field_size' bytes, and 'target' describes the object that it points to.
+        virtual void edge(
+            const void * field, std::size_t field_size, std::int64_t offset,
+            const object_type & target) = 0;
+
+        // Called for checks which dereference pointers, e.g., whether the keys of a map are
+        // sorted. They must only be run after all reachable objects have been verified.
+        virtual void check(const void * value, void (*check)(const void * value)) = 0;
+
+    protected:
+        ~layout_visitor() = default;
+    };
+
+    // Type-erased description of the objects that pointers point to
+    struct object_type
+    {
+        std::size_t alignment;
+
+        // Whether the object contains pointers. Objects without pointers are leaves of the
+        // object graph.
+        bool has_pointers;
+
+        // Returns the size of the object at 'object', including the items which are stored
+        // behind its fixed-size members. Throws std::invalid_argument if the object does not
+        // fit into 'available' bytes, or if its members are inconsistent.
+        std::size_t (*size)(const char * object, std::size_t available);
+
+        // Visits all pointers and checks of the object
+        void (*visit)(const char * object, layout_visitor & visitor);
+
+        // Objects which are moved keep their offset relative to the start of the blob modulo
+        // 'placement', e.g., such that an index stays aligned to cache lines. It is a multiple
+        // of 'alignment'.
+        std::size_t placement;
+    };
+
+    // Lists the data members of a struct which is stored in a blob, such that the pointers in
+    // it can be found, e.g.:
+    //
+    //     template <>
+    //     struct pid::struct_members<person>
+    //     {
+    //         static constexpr auto members{std::make_tuple(&person::name, &person::age)};
+    //     };
+    template <typename T>
+    struct struct_members;
+
+    // Describes how objects which may be followed by a variable number of items are stored.
+    // By default, an object consists of a single value of type T.
+    template <typename T>
+    struct object_layout
+    {
+        static constexpr bool has_pointers{type_layout<T>::has_pointers};
+
+        static std::size_t size(const T &, std::size_t)
+        {
+            return sizeof(T);
+        }
+
+        static void visit(layout_visitor & visitor, const T & object)
+        {
+            type_layout<T>::visit(visitor, object);
+        }
+    };
+
+    namespace detail {
+        // Returns 'size' if it does not exceed 'available'. Sizes are computed with 128 bits,
+        // such that corrupted lengths cannot cause an overflow.
+        inline std::size_t checked_size(unsigned __int128 size, std::size_t available)
+        {
+            if (size > available) {
+                throw std::invalid_argument{"object exceeds the blob"};
+            }
+            return static_cast<std::size_t>(size);
+        }
+
+        template <typename T, typename Pointer>
+        struct member_type
+        {
+            using type = std::remove_cvref_t<decltype(std::declval<const T &>().*
+                                                      std::declval<Pointer>())>;
+        };
+
+        template <typename T>
+        constexpr bool members_have_pointers()
+        {
+            return std::apply(
+                [](auto... members) {
+                    return (
+                        false || ...
+                        || type_layout<typename member_type<T, decltype(members)>::type>::
+                            has_pointers);
+                },
+                struct_members<T>::members);
+        }
+    }
+
+    namespace detail {
+        // object_layout<T>::placement if it exists, alignof(T) otherwise
+        template <typename T>
+        constexpr std::size_t placement_of()
+        {
+            if constexpr (requires { object_layout<T>::placement; }) {
+                static_assert(object_layout<T>::placement % alignof(T) == 0);
+                return object_layout<T>::placement;
+            } else {
+                return alignof(T);
+            }
+        }
+    }
+
+    template <typename Object>
+    inline constexpr object_type object_type_of{
+        alignof(Object),
+        object_layout<Object>::has_pointers,
+        [](const char * object, std::size_t available) -> std::size_t {
+            // The fixed-size members must be checked before they are read
+            if (available < sizeof(Object)) {
+                throw std::invalid_argument{"object exceeds the blob"};
+            }
+            return object_layout<Object>::size(
+                *reinterpret_cast<const Object *>(object), available);
+        },
+        [](const char * object, layout_visitor & visitor) {
+            object_layout<Object>::visit(visitor, *reinterpret_cast<const Object *>(object));
+        },
+        detail::placement_of<Object>()};
+
+    // Structs, which must be described with struct_members
+    template <typename T>
+    struct type_layout
+    {
+        static_assert(
+            requires { struct_members<T>::members; },
+            "pid::struct_members must be specialized for structs which are stored in blobs");
+
+        static constexpr bool has_pointers{detail::members_have_pointers<T>()};
+
+        static void visit(layout_visitor & visitor, const T & value)
+        {
+            if constexpr (has_pointers) {
+                std::apply(
+                    [&](auto... members) {
+                        (type_layout<typename detail::member_type<T, decltype(members)>::type>::
+                             visit(visitor, value.*members),
+                         ...);
+                    },
+                    struct_members<T>::members);
+            }
+        }
+    };
+
+    template <typename T>
+        requires(std::is_arithmetic_v<T> or std::is_enum_v<T>)
+    struct type_layout<T>
+    {
+        static constexpr bool has_pointers{false};
+
+        static void visit(layout_visitor &, const T &) {}
+    };
+
+    template <typename T, std::size_t N>
+    struct type_layout<T[N]>
+    {
+        static constexpr bool has_pointers{type_layout<T>::has_pointers};
+
+        static void visit(layout_visitor & visitor, const T (&value)[N])
+        {
+            if constexpr (has_pointers) {
+                for (const auto & item : value) {
+                    type_layout<T>::visit(visitor, item);
+                }
+            }
+        }
+    };
+
+    template <typename T, std::size_t N>
+    struct type_layout<std::array<T, N>>
+    {
+        static constexpr bool has_pointers{type_layout<T>::has_pointers};
+
+        static void visit(layout_visitor & visitor, const std::array<T, N> & value)
+        {
+            if constexpr (has_pointers) {
+                for (const auto & item : value) {
+                    type_layout<T>::visit(visitor, item);
+                }
+            }
+        }
+    };
+
+    template <typename First, typename Second>
+    struct type_layout<std::pair<First, Second>>
+    {
+        static constexpr bool has_pointers{
+            type_layout<First>::has_pointers or type_layout<Second>::has_pointers};
+
+        static void visit(layout_visitor & visitor, const std::pair<First, Second> & value)
+        {
+            type_layout<First>::visit(visitor, value.first);
+            type_layout<Second>::visit(visitor, value.second);
+        }
+    };
+
+    template <typename T>
+    struct type_layout<std::optional<T>>
+    {
+        static constexpr bool has_pointers{type_layout<T>::has_pointers};
+
+        static void visit(layout_visitor & visitor, const std::optional<T> & value)
+        {
+            if (has_pointers and value.has_value()) {
+                type_layout<T>::visit(visitor, *value);
+            }
+        }
+    };
+
+    // Null pointers are allowed
+    template <typename T, typename OffsetType>
+    struct type_layout<detail::ptr<T, OffsetType>>
+    {
+        static constexpr bool has_pointers{true};
+
+        static void visit(layout_visitor & visitor, const detail::ptr<T, OffsetType> & value)
+        {
+            if (value) {
+                visitor.edge(&value, sizeof(OffsetType), value.offset, object_type_of<T>);
+            }
+        }
+    };
+
+    // Helper for the containers whose handle is a pointer that must be dereferenceable
+    template <typename DataType, typename OffsetType>
+    void visit_data_pointer(layout_visitor & visitor, const detail::ptr<DataType, OffsetType> & p)
+    {
+        visitor.edge(&p, sizeof(OffsetType), p.offset, object_type_of<DataType>);
+    }
+
+    template <typename OffsetType, typename SizeType>
+    struct type_layout<detail::generic_string<OffsetType, SizeType>>
+    {
+        static constexpr bool has_pointers{true};
+
+        static void visit(
+            layout_visitor & visitor, const detail::generic_string<OffsetType, SizeType> & value)
+        {
+            visit_data_pointer(visitor, value.data);
+        }
+    };
+
+    template <typename OffsetType, typename SizeType>
+    struct type_layout<detail::generic_hashed_string<OffsetType, SizeType>>
+    {
+        static constexpr bool has_pointers{true};
+
+        static void visit(
+            layout_visitor & visitor,
+            const detail::generic_hashed_string<OffsetType, SizeType> & value)
+        {
+            visit_data_pointer(visitor, value.data);
+        }
+    };
+
+    // Only long strings have a pointer
+    template <typename OffsetType>
+    struct type_layout<detail::generic_prefix_string<OffsetType>>
+    {
+        static constexpr bool has_pointers{true};
+
+        static void visit(
+            layout_visitor & visitor, const detail::generic_prefix_string<OffsetType> & value)
+        {
+            if (not value.is_inline()) {
+                visit_data_pointer(visitor, value.data());
+            }
+        }
+    };
+
+    template <typename T, typename OffsetType, typename SizeType>
+    struct type_layout<detail::generic_vector<T, OffsetType, SizeType>>
+    {
+        static constexpr bool has_pointers{true};
+
+        static void visit(
+            layout_visitor & visitor,
+            const detail::generic_vector<T, OffsetType, SizeType> & value)
+        {
+            visit_data_pointer(visitor, value.data);
+        }
+    };
+
+    template <typename Key, typename Value, typename OffsetType, typename SizeType>
+    struct type_layout<detail::generic_map<Key, Value, OffsetType, SizeType>>
+    {
+        using MapType = detail::generic_map<Key, Value, OffsetType, SizeType>;
+
+        static constexpr bool has_pointers{true};
+
+        static void visit(layout_visitor & visitor, const MapType & value)
+        {
+            type_layout<typename MapType::VectorType>::visit(visitor, value.items);
+            visitor.check(&value, check_sorted);
+        }
+
+        static void check_sorted(const void * value)
+        {
+            const auto & map{*static_cast<const MapType *>(value)};
+            const auto it{std::adjacent_find(
+                map.begin(), map.end(), [](const auto & a, const auto & b) {
+                    return not(detail::get_key(a) < detail::get_key(b));
+                })};
+
+            if (it != map.end()) {
+                throw std::invalid_argument{"map keys are not sorted"};
+            }
+        }
+    };
+
+    template <typename Key, typename Value, typename OffsetType, typename SizeType>
+    struct type_layout<detail::generic_eytzinger_map<Key, Value, OffsetType, SizeType>>
+    {
+        using MapType = detail::generic_eytzinger_map<Key, Value, OffsetType, SizeType>;
+
+        static constexpr bool has_pointers{true};
+
+        static void visit(layout_visitor & visitor, const MapType & value)
+        {
+            type_layout<typename MapType::VectorType>::visit(visitor, value.items);
+            visitor.check(&value, check_sorted);
+        }
+
+        // The in-order traversal of the implicit tree must visit the keys in sorted order
+        static void check_sorted(const void * value)
+        {
+            const auto & map{*static_cast<const MapType *>(value)};
+            const std::size_t n{map.size()};
+            const auto * const data{map.begin()};
+
+            const typename MapType::ItemType * previous{nullptr};
+            std::size_t k{1};
+            while (n > 0 and 2 * k <= n) {
+                k = 2 * k;
+            }
+
+            while (n > 0 and k != 0) {
+                const auto & item{data[k - 1]};
+                if (previous != nullptr
+                    and not(detail::get_key(*previous) < detail::get_key(item))) {
+                    throw std::invalid_argument{"map keys are not in Eytzinger order"};
+                }
+                previous = &item;
+
+                // Go to the in-order successor: the leftmost item in the right subtree, or the
+                // first ancestor whose left subtree contains the current item.
+                if (2 * k + 1 <= n) {
+                    k = 2 * k + 1;
+                    while (2 * k <= n) {
+                        k = 2 * k;
+                    }
+                } else {
+                    k >>= std::countr_one(k) + 1;
+                }
+            }
+        }
+    };
+
+    template <typename Key, typename Value, typename OffsetType, typename SizeType>
+    struct type_layout<detail::generic_hash_map<Key, Value, OffsetType, SizeType>>
+    {
+        using MapType = detail::generic_hash_map<Key, Value, OffsetType, SizeType>;
+
+        static constexpr bool has_pointers{true};
+
+        static void visit(layout_visitor & visitor, const MapType & value)
+        {
+            visit_data_pointer(visitor, value.data);
+            visitor.check(&value, check_positions);
+        }
+
+        // Each item must be at the position that the hash function yields for its key,
+        // otherwise it could not be found
+        static void check_positions(const void * value)
+        {
+            const auto & data{*static_cast<const MapType *>(value)->data};
+            const auto * const items{data.items()};
+
+            for (std::size_t i{0}; i < data.map_size; ++i) {
+                const auto & key{detail::get_key(items[i])};
+                if (data.position(detail::hash_key(key, data.seed)) != i) {
+                    throw std::invalid_argument{"hash map item is not at its hash position"};
+                }
+            }
+        }
+    };
+
+    template <typename Key, typename Value, typename OffsetType, typename SizeType>
+    struct type_layout<detail::generic_soa_map<Key, Value, OffsetType, SizeType>>
+    {
+        using MapType = detail::generic_soa_map<Key, Value, OffsetType, SizeType>;
+
+        static constexpr bool has_pointers{true};
+
+        static void visit(layout_visitor & visitor, const MapType & value)
+        {
+            type_layout<typename MapType::KeyVectorType>::visit(visitor, value.key_vector);
+            type_layout<typename MapType::ValueVectorType>::visit(visitor, value.value_vector);
+            visitor.check(&value, check_sorted);
+        }
+
+        static void check_sorted(const void * value)
+        {
+            const auto & map{*static_cast<const MapType *>(value)};
+            if (map.keys().size() != map.values().size()) {
+                throw std::invalid_argument{"map has different numbers of keys and values"};
+            }
+
+            const auto it{std::adjacent_find(
+                map.keys().begin(), map.keys().end(), [](const auto & a, const auto & b) {
+                    return not(detail::key_value(a) < detail::key_value(b));
+                })};
+
+            if (it != map.keys().end()) {
+                throw std::invalid_argument{"map keys are not sorted"};
+            }
+        }
+    };
+
+    template <typename Key, typename Value, typename OffsetType, typename SizeType>
+    struct type_layout<detail::generic_s_tree_map<Key, Value, OffsetType, SizeType>>
+    {
+        using MapType = detail::generic_s_tree_map<Key, Value, OffsetType, SizeType>;
+
+        static constexpr bool has_pointers{true};
+
+        static void visit(layout_visitor & visitor, const MapType & value)
+        {
+            type_layout<typename MapType::VectorType>::visit(visitor, value.items);
+            visit_data_pointer(visitor, value.index);
+            visitor.check(&value, check_index);
+        }
+
+        // The keys must be sorted, and the search tree must be the one which the builder
+        // would store for them
+        static void check_index(const void * value)
+        {
+            using IndexDataType = typename MapType::IndexDataType;
+
+            const auto & map{*static_cast<const MapType *>(value)};
+            const IndexDataType & index{*map.index};
+            if (index.key_count != map.size()) {
+                throw std::invalid_argument{"search tree has a different number of keys"};
+            }
+
+            const auto it{std::adjacent_find(
+                map.begin(), map.end(),
+                [](const auto & a, const auto & b) { return not(a.first < b.first); })};
+            if (it != map.end()) {
+                throw std::invalid_argument{"map keys are not sorted"};
+            }
+
+            std::vector<Key> expected(
+                IndexDataType::index_size(map.size()), std::numeric_limits<Key>::max());
+            for (std::size_t rank{0}; rank < map.size(); ++rank) {
+                IndexDataType::positions(map.size(), rank, [&](std::size_t position) {
+                    expected[position] = map.begin()[rank].first;
+                });
+            }
+
+            if (not std::equal(expected.begin(), expected.end(), index.keys())) {
+                throw std::invalid_argument{"search tree does not match the keys"};
+            }
+        }
+    };
+
+    template <typename T, typename OffsetType, typename SizeType>
+    struct type_layout<detail::generic_packed_vector<T, OffsetType, SizeType>>
+    {
+        static constexpr bool has_pointers{true};
+
+        static void visit(
+            layout_visitor & visitor,
+            const detail::generic_packed_vector<T, OffsetType, SizeType> & value)
+        {
+            visit_data_pointer(visitor, value.data);
+        }
+    };
+
+    template <typename OffsetType, typename SizeType>
+    struct type_layout<detail::generic_string_vector<OffsetType, SizeType>>
+    {
+        static constexpr bool has_pointers{true};
+
+        static void visit(
+            layout_visitor & visitor,
+            const detail::generic_string_vector<OffsetType, SizeType> & value)
+        {
+            visit_data_pointer(visitor, value.data);
+        }
+    };
+
+    template <typename OffsetType, typename SizeType>
+    struct type_layout<detail::generic_compressed_string_vector<OffsetType, SizeType>>
+    {
+        static constexpr bool has_pointers{true};
+
+        static void visit(
+            layout_visitor & visitor,
+            const detail::generic_compressed_string_vector<OffsetType, SizeType> & value)
+        {
+            visit_data_pointer(visitor, value.data);
+        }
+    };
+
+    template <typename DataType, typename OffsetType, typename SizeType>
+    struct type_layout<detail::generic_bitmap_vector<DataType, OffsetType, SizeType>>
+    {
+        static constexpr bool has_pointers{true};
+
+        static void visit(
+            layout_visitor & visitor,
+            const detail::generic_bitmap_vector<DataType, OffsetType, SizeType> & value)
+        {
+            visit_data_pointer(visitor, value.data);
+        }
+    };
+
+    // Strings must be NUL-terminated, because generic_string_data::end() is used like a C
+    // string by some callers
+    template <typename SizeType>
+    struct object_layout<detail::generic_string_data<SizeType>>
+    {
+        using DataType = detail::generic_string_data<SizeType>;
+
+        static constexpr bool has_pointers{false};
+
+        static std::size_t size(const DataType & object, std::size_t available)
+        {
+            const std::size_t result{detail::checked_size(
+                static_cast<unsigned __int128>(sizeof(DataType)) + object.string_length + 1,
+                available)};
+
+            if (object.data[object.string_length] != 0) {
+                throw std::invalid_argument{"string is not NUL-terminated"};
+            }
+
+            return result;
+        }
+
+        static void visit(layout_visitor &, const DataType &) {}
+    };
+
+    // The stored hash must be correct, because comparisons trust it
+    template <typename SizeType>
+    struct object_layout<detail::generic_hashed_string_data<SizeType>>
+    {
+        using DataType = detail::generic_hashed_string_data<SizeType>;
+
+        static constexpr bool has_pointers{false};
+
+        static std::size_t size(const DataType & object, std::size_t available)
+        {
+            const std::size_t result{detail::checked_size(
+                static_cast<unsigned __int128>(sizeof(DataType)) + object.string_length + 1,
+                available)};
+
+            if (object.data[object.string_length] != 0) {
+                throw std::invalid_argument{"string is not NUL-terminated"};
+            }
+            if (object.string_hash != DataType::hash_of(object)) {
+                throw std::invalid_argument{"string hash is wrong"};
+            }
+
+            return result;
+        }
+
+        static void visit(layout_visitor &, const DataType &) {}
+    };
+
+    template <typename T, typename SizeType>
+    struct object_layout<detail::generic_vector_data<T, SizeType>>
+    {
+        using DataType = detail::generic_vector_data<T, SizeType>;
+
+        static constexpr bool has_pointers{type_layout<T>::has_pointers};
+
+        static std::size_t size(const DataType & object, std::size_t available)
+        {
+            return detail::checked_size(
+                sizeof(DataType)
+                    + static_cast<unsigned __int128>(object.vector_length) * sizeof(T),
+                available);
+        }
+
+        static void visit(layout_visitor & visitor, const DataType & object)
+        {
+            if constexpr (has_pointers) {
+                for (const T & item : object) {
+                    type_layout<T>::visit(visitor, item);
+                }
+            }
+        }
+    };
+
+    template <typename Key, typename Value, typename SizeType>
+    struct object_layout<detail::generic_hash_map_data<Key, Value, SizeType>>
+    {
+        using DataType = detail::generic_hash_map_data<Key, Value, SizeType>;
+        using ItemType = typename DataType::ItemType;
+
+        static constexpr bool has_pointers{type_layout<ItemType>::has_pointers};
+
+        static std::size_t size(const DataType & object, std::size_t available)
+        {
+            if (object.map_size > 0 and object.bucket_count == 0) {
+                throw std::invalid_argument{"hash map has no buckets"};
+            }
+
+            // Check the pilots first, such that items_offset() cannot overflow
+            detail::checked_size(
+                offsetof(DataType, pilots)
+                    + static_cast<unsigned __int128>(object.bucket_count)
+                          * sizeof(std::uint32_t),
+                available);
+
+            return detail::checked_size(
+                DataType::items_offset(object.bucket_count)
+                    + static_cast<unsigned __int128>(object.map_size) * sizeof(ItemType),
+                available);
+        }
+
+        static void visit(layout_visitor & visitor, const DataType & object)
+        {
+            if constexpr (has_pointers) {
+                const ItemType * const items{object.items()};
+                for (std::size_t i{0}; i < object.map_size; ++i) {
+                    type_layout<ItemType>::visit(visitor, items[i]);
+                }
+            }
+        }
+    };
+
+    template <typename T, typename SizeType>
+    struct object_layout<detail::generic_packed_vector_data<T, SizeType>>
+    {
+        using DataType = detail::generic_packed_vector_data<T, SizeType>;
+
+        static constexpr bool has_pointers{false};
+
+        static std::size_t size(const DataType & object, std::size_t available)
+        {
+            const std::size_t length{object.vector_length};
+            const std::size_t block_count{DataType::block_count(length)};
+
+            // The positions of the blocks must be read before the size is known
+            detail::checked_size(
+                sizeof(DataType)
+                    + static_cast<unsigned __int128>(block_count) * 2 * sizeof(std::uint64_t),
+                available);
+
+            std::size_t bit_count{0};
+            for (std::size_t block{0}; block < block_count; ++block) {
+                if (object.bit_width(block) > 64 or object.first_bit(block) != bit_count) {
+                    throw std::invalid_argument{"packed vector has invalid blocks"};
+                }
+                const std::size_t values{
+                    std::min(length - block * DataType::block_size, DataType::block_size)};
+                bit_count += values * object.bit_width(block);
+            }
+
+            return detail::checked_size(
+                sizeof(DataType)
+                    + static_cast<unsigned __int128>(DataType::word_count(length, bit_count))
+                          * sizeof(std::uint64_t),
+                available);
+        }
+
+        static void visit(layout_visitor &, const DataType &) {}
+    };
+
+    template <typename T, typename SizeType>
+    struct object_layout<detail::generic_optional_vector_data<T, SizeType>>
+    {
+        using DataType = detail::generic_optional_vector_data<T, SizeType>;
+
+        static constexpr bool has_pointers{false};
+
+        static std::size_t size(const DataType & object, std::size_t available)
+        {
+            const auto length{static_cast<unsigned __int128>(object.vector_length)};
+            return detail::checked_size(
+                sizeof(DataType) + (length + 63) / 64 * sizeof(std::uint64_t)
+                    + length * sizeof(T),
+                available);
+        }
+
+        static void visit(layout_visitor &, const DataType &) {}
+    };
+
+    namespace detail {
+        // Checks that the offsets of a vector of strings are ascending and returns the size
+        // of the data, given the size of everything in front of the characters
+        template <typename SizeType>
+        std::size_t checked_string_vector_size(
+            const SizeType * offsets, std::size_t length, std::size_t characters_offset,
+            std::size_t available)
+        {
+            for (std::size_t i{0}; i < length; ++i) {
+                if (offsets[i] > offsets[i + 1]) {
+                    throw std::invalid_argument{"string offsets are not ascending"};
+                }
+            }
+
+            return checked_size(
+                static_cast<unsigned __int128>(characters_offset) + offsets[length], available);
+        }
+    }
+
+    template <typename SizeType>
+    struct object_layout<detail::generic_optional_string_vector_data<SizeType>>
+    {
+        using DataType = detail::generic_optional_string_vector_data<SizeType>;
+
+        static constexpr bool has_pointers{false};
+
+        static std::size_t size(const DataType & object, std::size_t available)
+        {
+            const auto length{static_cast<unsigned __int128>(object.vector_length)};
+            const std::size_t characters_offset{detail::checked_size(
+                sizeof(DataType) + (length + 63) / 64 * sizeof(std::uint64_t)
+                    + (length + 1) * sizeof(SizeType),
+                available)};
+
+            return detail::checked_string_vector_size(
+                object.offsets(), object.vector_length, characters_offset, available);
+        }
+
+        static void visit(layout_visitor &, const DataType &) {}
+    };
+
+    template <typename SizeType>
+    struct object_layout<detail::generic_string_vector_data<SizeType>>
+    {
+        using DataType = detail::generic_string_vector_data<SizeType>;
+
+        static constexpr bool has_pointers{false};
+
+        static std::size_t size(const DataType & object, std::size_t available)
+        {
+            const std::size_t characters_offset{detail::checked_size(
+                sizeof(DataType)
+                    + (static_cast<unsigned __int128>(object.vector_length) + 1)
+                          * sizeof(SizeType),
+                available)};
+
+            return detail::checked_string_vector_size(
+                object.offsets, object.vector_length, characters_offset, available);
+        }
+
+        static void visit(layout_visitor &, const DataType &) {}
+    };
+
+    template <typename SizeType>
+    struct object_layout<detail::generic_compressed_string_vector_data<SizeType>>
+    {
+        using DataType = detail::generic_compressed_string_vector_data<SizeType>;
+
+        static constexpr bool has_pointers{false};
+
+        static std::size_t size(const DataType & object, std::size_t available)
+        {
+            if (object.symbol_count > DataType::max_symbols) {
+                throw std::invalid_argument{"too many symbols"};
+            }
+
+            const std::size_t codes_offset{detail::checked_size(
+                sizeof(DataType)
+                    + (static_cast<unsigned __int128>(object.vector_length) + 1)
+                          * sizeof(SizeType)
+                    + std::size_t{object.symbol_count} * (DataType::max_symbol_length + 1),
+                available)};
+            const std::size_t result{detail::checked_string_vector_size(
+                object.offsets, object.vector_length, codes_offset, available)};
+
+            const std::uint8_t * const lengths{object.symbol_lengths()};
+            for (std::size_t i{0}; i < object.symbol_count; ++i) {
+                if (lengths[i] == 0 or lengths[i] > DataType::max_symbol_length) {
+                    throw std::invalid_argument{"symbol length is out of range"};
+                }
+            }
+
+            // Decompressing a string must not read codes of the next one. The codes must also be
+            // the encoding of the decompressed string, like the builder creates them, because
+            // equal() compares the codes instead of the strings.
+            const char * const codes{object.codes()};
+            std::string decompressed;
+            for (std::size_t i{0}; i < object.vector_length; ++i) {
+                decompressed.clear();
+                for (std::size_t j{object.offsets[i]}; j < object.offsets[i + 1]; ++j) {
+                    const auto code{static_cast<std::uint8_t>(codes[j])};
+                    if (code == detail::symbol_escape_code) {
+                        if (++j == object.offsets[i + 1]) {
+                            throw std::invalid_argument{"escape code at the end of a string"};
+                        }
+                        decompressed += codes[j];
+                    } else if (code >= object.symbol_count) {
+                        throw std::invalid_argument{"invalid symbol code"};
+                    } else {
+                        decompressed.append(
+                            object.symbols() + std::size_t{code} * DataType::max_symbol_length,
+                            lengths[code]);
+                    }
+                }
+
+                std::size_t position{object.offsets[i]};
+                const bool canonical{
+                    object.encode(
+                        decompressed,
+                        [&](std::uint8_t code) {
+                            return position < object.offsets[i + 1]
+                                   and static_cast<std::uint8_t>(codes[position++]) == code;
+                        })
+                    and position == object.offsets[i + 1]};
+                if (not canonical) {
+                    throw std::invalid_argument{"string is not encoded with the symbol table"};
+                }
+            }
+
+            return result;
+        }
+
+        static void visit(layout_visitor &, const DataType &) {}
+    };
+
+    template <typename Key, typename SizeType>
+    struct object_layout<detail::generic_s_tree_data<Key, SizeType>>
+    {
+        using DataType = detail::generic_s_tree_data<Key, SizeType>;
+
+        static constexpr bool has_pointers{false};
+
+        // The padding aligns the keys to cache lines relative to the start of the blob
+        static constexpr std::size_t placement{DataType::cache_line_size};
+
+        static std::size_t size(const DataType & object, std::size_t available)
+        {
+            if (object.padding >= DataType::cache_line_size
+                or object.padding % alignof(Key) != 0) {
+                throw std::invalid_argument{"search tree has invalid padding"};
+            }
+
+            // Avoids an overflow of index_size()
+            if (object.key_count > available / sizeof(Key)) {
+                throw std::invalid_argument{"object exceeds the blob"};
+            }
+
+            std::uint64_t layer_offsets[DataType::max_layers];
+            if (object.layer_count != DataType::layer_offsets_of(object.key_count, layer_offsets)
+                or not std::equal(
+                    layer_offsets, layer_offsets + DataType::max_layers, object.layer_offsets)) {
+                throw std::invalid_argument{"search tree has invalid layers"};
+            }
+
+            return detail::checked_size(
+                sizeof(DataType) + std::size_t{object.padding}
+                    + static_cast<unsigned __int128>(DataType::index_size(object.key_count))
+                          * sizeof(Key),
+                available);
+        }
+
+        static void visit(layout_visitor &, const DataType &) {}
+    };
+}
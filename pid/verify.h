@@ -0,0 +1,324 @@
+#pragma once
+
+#include "type-layout.h"
+#include "mapped-blob.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <span>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace pid {
+    namespace detail {
+        // Verifies all objects which are reachable from a root object, see pid::verify().
+        //
+        // The objects are processed with an explicit stack instead of recursion, such that
+        // deeply nested data cannot overflow the call stack. Each object is verified only
+        // once, even if many pointers point to it, and cycles are harmless.
+        class blob_verifier
+        {
+        public:
+            explicit blob_verifier(std::span<const char> blob) : blob{blob} {}
+
+            void run(
+                std::size_t root_offset, const object_type & root_type, std::size_t thread_count)
+            {
+                thread_count = std::max<std::size_t>(thread_count, 1);
+                concurrent = thread_count > 1;
+
+                worker main{*this};
+                if (root_offset >= blob.size()) {
+                    fail("root object is outside of the blob", root_offset);
+                }
+                main.stack.push_back({root_offset, &root_type});
+
+                if (not concurrent) {
+                    main.run();
+                    run_checks(main.checks, 1);
+                    return;
+                }
+
+                // Verify the objects near the root breadth-first, until there are enough
+                // subtrees to keep all threads busy
+                const std::size_t task_count{64 * thread_count};
+                std::size_t next{0};
+                while (next < main.stack.size() and main.stack.size() - next < task_count) {
+                    const task t{main.stack[next++]};
+                    main.process(t);
+                }
+
+                const std::vector<task> tasks(main.stack.begin() + next, main.stack.end());
+                main.stack.clear();
+
+                std::vector<std::unique_ptr<worker>> workers;
+                for (std::size_t i{0}; i < thread_count; ++i) {
+                    workers.push_back(std::make_unique<worker>(*this));
+                }
+
+                std::atomic<std::size_t> next_task{0};
+                run_in_parallel(thread_count, [&](std::size_t thread_index) {
+                    worker & w{*workers[thread_index]};
+                    for (std::size_t i{next_task++}; i < tasks.size() and not failed;
+                         i = next_task++) {
+                        w.stack.push_back(tasks[i]);
+                        w.run();
+                    }
+                });
+
+                for (const auto & w : workers) {
+                    main.checks.insert(main.checks.end(), w->checks.begin(), w->checks.end());
+                }
+                run_checks(main.checks, thread_count);
+            }
+
+        private:
+            struct task
+            {
+                std::size_t offset;
+                const object_type * type;
+            };
+
+            struct deferred_check
+            {
+                const void * value;
+                void (*check)(const void *);
+            };
+
+            struct free_deleter
+            {
+                void operator()(std::uint64_t * p) const
+                {
+                    std::free(p);
+                }
+            };
+
+            // One bit for each position where an object of the given type may start, which
+            // tells if that object has been verified already. The bitmap is allocated with
+            // calloc, such that the kernel provides zeroed pages lazily for large blobs.
+            struct visited_bitmap
+            {
+                const object_type * type;
+                std::unique_ptr<std::uint64_t, free_deleter> bits;
+            };
+
+            class worker final : public layout_visitor
+            {
+            public:
+                explicit worker(blob_verifier & verifier) : verifier{verifier} {}
+
+                std::vector<task> stack;
+                std::vector<deferred_check> checks;
+
+                void edge(
+                    const void * field, std::size_t, std::int64_t offset,
+                    const object_type & target) override
+                {
+                    const auto field_offset{static_cast<std::int64_t>(
+                        static_cast<const char *>(field) - verifier.blob.data())};
+
+                    std::int64_t target_offset;
+                    if (__builtin_add_overflow(field_offset, offset, &target_offset)
+                        or target_offset < 0
+                        or static_cast<std::uint64_t>(target_offset) >= verifier.blob.size()) {
+                        fail("pointer points outside of the blob", field_offset);
+                    }
+
+                    stack.push_back({static_cast<std::size_t>(target_offset), &target});
+                }
+
+                void check(const void * value, void (*check)(const void * value)) override
+                {
+                    checks.push_back({value, check});
+                }
+
+                void process(const task & t)
+                {
+                    const char * const object{verifier.blob.data() + t.offset};
+                    if (reinterpret_cast<std::uintptr_t>(object) % t.type->alignment != 0) {
+                        fail("object is not aligned", t.offset);
+                    }
+
+                    if (not mark_visited(t)) {
+                        return;
+                    }
+
+                    try {
+                        t.type->size(object, verifier.blob.size() - t.offset);
+                    } catch (const std::invalid_argument & e) {
+                        fail(e.what(), t.offset);
+                    }
+
+                    t.type->visit(object, *this);
+                }
+
+                void run()
+                {
+                    while (not stack.empty() and not verifier.failed) {
+                        const task t{stack.back()};
+                        stack.pop_back();
+                        process(t);
+                    }
+                }
+
+            private:
+                blob_verifier & verifier;
+
+                // Bitmaps of the types which this worker has seen so far. A blob contains
+                // only a few different object types, so a linear search is fast.
+                std::vector<std::pair<const object_type *, std::uint64_t *>> bitmaps;
+
+                // Returns false if the object has been visited before
+                bool mark_visited(const task & t)
+                {
+                    std::uint64_t * bits{nullptr};
+                    for (const auto & [type, type_bits] : bitmaps) {
+                        if (type == t.type) {
+                            bits = type_bits;
+                            break;
+                        }
+                    }
+
+                    if (bits == nullptr) {
+                        bits = verifier.bitmap_for(*t.type);
+                        bitmaps.emplace_back(t.type, bits);
+                    }
+
+                    const std::size_t index{t.offset / t.type->alignment};
+                    const std::uint64_t mask{std::uint64_t{1} << (index % 64)};
+                    std::uint64_t & word{bits[index / 64]};
+
+                    if (verifier.concurrent) {
+                        return (std::atomic_ref{word}.fetch_or(mask, std::memory_order_relaxed)
+                                & mask)
+                               == 0;
+                    }
+
+                    const bool visited{(word & mask) != 0};
+                    word |= mask;
+                    return not visited;
+                }
+            };
+
+            std::span<const char> blob;
+            bool concurrent{false};
+            std::atomic<bool> failed{false};
+
+            std::mutex bitmaps_mutex;
+            std::vector<visited_bitmap> bitmaps;
+
+            [[noreturn]] static void fail(const std::string & message, std::size_t offset)
+            {
+                throw std::invalid_argument{message + " at offset " + std::to_string(offset)};
+            }
+
+            std::uint64_t * bitmap_for(const object_type & type)
+            {
+                std::lock_guard lock{bitmaps_mutex};
+                for (const auto & bitmap : bitmaps) {
+                    if (bitmap.type == &type) {
+                        return bitmap.bits.get();
+                    }
+                }
+
+                const std::size_t word_count{
+                    bitmap_word_count(blob.size() / type.alignment + 1)};
+                auto * bits{static_cast<std::uint64_t *>(
+                    std::calloc(word_count, sizeof(std::uint64_t)))};
+                if (bits == nullptr) {
+                    throw std::bad_alloc{};
+                }
+
+                bitmaps.push_back({&type, std::unique_ptr<std::uint64_t, free_deleter>{bits}});
+                return bits;
+            }
+
+            void run_checks(const std::vector<deferred_check> & checks, std::size_t thread_count)
+            {
+                const auto run_check{[&](const deferred_check & c) {
+                    try {
+                        c.check(c.value);
+                    } catch (const std::invalid_argument & e) {
+                        fail(e.what(), static_cast<const char *>(c.value) - blob.data());
+                    }
+                }};
+
+                if (thread_count == 1) {
+                    for (const auto & c : checks) {
+                        run_check(c);
+                    }
+                    return;
+                }
+
+                std::atomic<std::size_t> next_check{0};
+                run_in_parallel(thread_count, [&](std::size_t) {
+                    for (std::size_t i{next_check++}; i < checks.size() and not failed;
+                         i = next_check++) {
+                        run_check(checks[i]);
+                    }
+                });
+            }
+
+            // Calls function(thread_index) in 'thread_count' threads and rethrows the first
+            // exception
+            template <typename Function>
+            void run_in_parallel(std::size_t thread_count, Function function)
+            {
+                std::exception_ptr error;
+                std::mutex error_mutex;
+
+                {
+                    std::vector<std::jthread> threads;
+                    for (std::size_t i{0}; i < thread_count; ++i) {
+                        threads.emplace_back([&, i] {
+                            try {
+                                function(i);
+                            } catch (...) {
+                                std::lock_guard lock{error_mutex};
+                                if (not error) {
+                                    error = std::current_exception();
+                                }
+                                failed = true;
+                            }
+                        });
+                    }
+                }
+
+                if (error) {
+                    std::rethrow_exception(error);
+                }
+            }
+        };
+    }
+
+    // Verifies that all objects which are reachable from the object of type Root at
+    // 'root_offset' can be accessed safely: pointers must point to aligned objects inside the
+    // blob, the sizes of strings, vectors and maps must fit into the blob, strings must be
+    // NUL-terminated, and the keys of maps must be in the order that lookups expect. Throws
+    // std::invalid_argument with the offset of the first problem that was found.
+    //
+    // Structs which are stored in the blob must be described with pid::struct_members. With
+    // thread_count > 1, independent subtrees are verified in parallel.
+    template <typename Root>
+    void verify(std::span<const char> blob, std::size_t root_offset, std::size_t thread_count = 1)
+    {
+        detail::blob_verifier{blob}.run(root_offset, object_type_of<Root>, thread_count);
+    }
+
+    // Like open_blob(), but also verifies all data which are reachable from the root object.
+    // This should be used for blobs which come from an untrusted source.
+    template <typename Root>
+    const Root & open_verified_blob(std::span<const char> blob, std::size_t thread_count = 1)
+    {
+        const Root & root{open_blob<Root>(blob)};
+        verify<Root>(
+            blob, static_cast<std::size_t>(reinterpret_cast<const char *>(&root) - blob.data()),
+            thread_count);
+        return root;
+    }
+}
@@ -1,8 +1,11 @@
 #include <pid/pid-build-datastructures.h>
+#include <pid/verify.h>
 
 #include "catch.hpp"
 #include "pid-debug.h"
 
+#include <cmath>
+#include <filesystem>
 #include <iostream>
 
 using namespace pid;
@@ -56,7 +59,7 @@ auto build_helper(const T & value)
     using ResultType = std::remove_reference<decltype(*result)>::type;
 
     const auto offset{result.offset};
-    std::vector<char> data{std::move(builder.data)};
+    std::vector<char> data{builder.data.begin(), builder.data.end()};
 
     const auto & reference{reinterpret_cast<const ResultType *>(data.data() + offset)};
 
@@ -65,6 +68,45 @@ auto build_helper(const T & value)
     return std::make_pair(reference, std::move(data));
 }
 
+template <typename Layout, typename Key, typename Value>
+auto build_map_helper(const std::map<Key, Value> & value)
+{
+    using MapType = typename Layout::template map_type<
+        typename pid_type<Key>::type, typename pid_type<Value>::type>;
+
+    pid::builder builder;
+    pid::datastructure_builder d_builder{builder};
+
+    const auto items{d_builder(value, Layout{})};
+    auto result{builder.add<MapType>()};
+    *result = items;
+
+    const auto offset{result.offset};
+    std::vector<char> data{builder.data.begin(), builder.data.end()};
+
+    const auto & reference{reinterpret_cast<const MapType *>(data.data() + offset)};
+    return std::make_pair(reference, std::move(data));
+}
+
+template <typename Layout, typename T>
+auto build_vector_helper(const std::vector<T> & value)
+{
+    using VectorType = typename Layout::template vector_type<typename T::value_type>;
+
+    pid::builder builder;
+    pid::datastructure_builder d_builder{builder};
+
+    const auto items{d_builder(value, Layout{})};
+    auto result{builder.add<VectorType>()};
+    *result = items;
+
+    const auto offset{result.offset};
+    std::vector<char> data{builder.data.begin(), builder.data.end()};
+
+    const auto & reference{reinterpret_cast<const VectorType *>(data.data() + offset)};
+    return std::make_pair(reference, std::move(data));
+}
+
 TEST_CASE("build vector of ints")
 {
     std::vector<std::int32_t> v_input{{1, 1, 2, 3, 5, 8}};
@@ -94,6 +136,44 @@ TEST_CASE("build vector of strings")
     CHECK(v[2] == "c");
 }
 
+TEST_CASE("build contiguous vector of strings")
+{
+    std::vector<std::string> v_input{{"a", "", "bcd", "UTF-8: Bäume", ""}};
+    const auto & [result, data] = build_vector_helper<string_vector_layout>(v_input);
+
+    const pid32::string_vector32 & v = *result;
+
+    REQUIRE(v.size() == 5);
+    CHECK(v[0] == "a");
+    CHECK(v[1].empty());
+    CHECK(v[2] == "bcd");
+    CHECK(v[3] == "UTF-8: Bäume");
+    CHECK(v.at(4).empty());
+    CHECK_THROWS_AS(v.at(5), std::out_of_range);
+
+    CHECK(std::equal(v.begin(), v.end(), v_input.begin(), v_input.end()));
+
+    // The characters of consecutive strings are adjacent
+    CHECK(v[2].data() == v[0].data() + 1);
+    CHECK(v[3].data() == v[2].data() + 3);
+}
+
+TEST_CASE("build compressed vector of strings")
+{
+    std::vector<std::string> v_input{{"a", "", "bcd", "UTF-8: Bäume", "bcd"}};
+    const auto & [result, data] = build_vector_helper<compressed_string_vector_layout>(v_input);
+
+    const pid32::compressed_string_vector32 & v = *result;
+
+    REQUIRE(v.size() == 5);
+    CHECK(v[0] == "a");
+    CHECK(v[1].empty());
+    CHECK(v[2] == "bcd");
+    CHECK(v[3] == "UTF-8: Bäume");
+    CHECK(v.equal(2, 4));
+    CHECK_THROWS_AS(v.at(5), std::out_of_range);
+}
+
 TEST_CASE("build map (int -> int)")
 {
     std::map<std::int32_t, std::int32_t> m_input{{42, 1}, {-1, 2}};
@@ -187,6 +267,56 @@ TEST_CASE("build map (str -> (str -> [int]))")
     CHECK(m.at("c").at("c2")[2] == 9);
 }
 
+TEST_CASE("find batch")
+{
+    std::map<std::int32_t, std::string> m_input;
+    for (std::int32_t i{0}; i < 1000; ++i) {
+        m_input[2 * i] = std::to_string(i);
+    }
+    const auto & [result, data] = build_helper(m_input);
+
+    const pid32::map32<std::int32_t, pid32::string32> & m = *result;
+
+    // More keys than fit into a group, including keys which are not in the map
+    std::vector<std::int32_t> keys;
+    for (std::int32_t key{-5}; key < 2010; key += 3) {
+        keys.push_back(key);
+    }
+
+    std::vector<pid32::map32<std::int32_t, pid32::string32>::const_iterator> results(
+        keys.size());
+    m.find_batch(std::span<const std::int32_t>{keys}, std::span{results});
+
+    for (std::size_t index{0}; index < keys.size(); ++index) {
+        CHECK(results[index] == m.find(keys[index]));
+    }
+    CHECK(results[3]->second == "2");
+
+    CHECK_THROWS_AS(
+        m.find_batch(std::span<const std::int32_t>{keys}, std::span{results}.first(1)),
+        std::invalid_argument);
+}
+
+TEST_CASE("find batch (str)")
+{
+    std::map<std::string, std::int32_t> m_input{{"one", 1}, {"two", 2}, {"three", 3}};
+    const auto & [result, data] = build_helper(m_input);
+
+    const pid32::map32<pid32::string32, std::int32_t> & m = *result;
+
+    const std::vector<std::string_view> keys{"two", "four", "one", "three", "", "zero"};
+    std::vector<pid32::map32<pid32::string32, std::int32_t>::const_iterator> results(
+        keys.size());
+    m.find_batch(std::span<const std::string_view>{keys}, std::span{results});
+
+    CHECK(results[0]->second == 2);
+    CHECK(results[1] == m.end());
+    CHECK(results[2]->second == 1);
+    CHECK(results[3]->second == 3);
+    CHECK(results[4] == m.end());
+    CHECK(results[5] == m.end());
+}
+
 TEST_CASE("build vector of optional ints")
 {
     std::vector<std::optional<std::int32_t>> v_input{{1, std::nullopt, 2, 3, 5, 8}};
@@ -222,6 +352,92 @@ TEST_CASE("build vector of optional strings")
     CHECK(*v[3] == "c");
 }
 
+TEST_CASE("build vector of optional ints with validity bitmap")
+{
+    std::vector<std::optional<std::int32_t>> v_input{{1, std::nullopt, 2, 3, std::nullopt, 8}};
+    for (std::int32_t i{0}; i < 100; ++i) {
+        v_input.push_back(i % 3 == 0 ? std::optional<std::int32_t>{i} : std::nullopt);
+    }
+    const auto & [result, data] = build_vector_helper<validity_bitmap_layout>(v_input);
+
+    const pid32::optional_vector32<std::int32_t> & v = *result;
+
+    REQUIRE(v.size() == 106);
+    CHECK(v.value_count() == 4 + 34);
+    CHECK(v[0] == 1);
+    CHECK(not v[1]);
+    CHECK(not v.has_value(1));
+    CHECK(v[2] == 2);
+    CHECK(v[3] == 3);
+    CHECK(v[4] == std::nullopt);
+    CHECK(v[5] == 8);
+    CHECK_THROWS_AS(v.at(106), std::out_of_range);
+
+    CHECK(std::equal(v.begin(), v.end(), v_input.begin(), v_input.end()));
+
+    // 4 bytes per item plus 1 bit, compared to 8 bytes for std::optional<std::int32_t>
+    CHECK(data.size() < v_input.size() * sizeof(std::int32_t) + 32);
+}
+
+TEST_CASE("build vector of optional strings with validity bitmap")
+{
+    std::vector<std::optional<std::string>> v_input{{"a", std::nullopt, "", "bcd", std::nullopt}};
+    const auto & [result, data] = build_vector_helper<validity_bitmap_layout>(v_input);
+
+    const pid32::optional_string_vector32 & v = *result;
+
+    REQUIRE(v.size() == 5);
+    CHECK(v.value_count() == 3);
+    CHECK(v[0] == "a");
+    CHECK(not v[1]);
+    REQUIRE(v[2]);
+    CHECK(v[2]->empty());
+    CHECK(v[3] == "bcd");
+    CHECK(not v[4]);
+
+    CHECK(std::equal(v.begin(), v.end(), v_input.begin(), v_input.end()));
+}
+
+TEST_CASE("build nested vectors of optionals with validity bitmap")
+{
+    using Column =
+        pid::with_layout<std::vector<std::optional<std::int32_t>>, validity_bitmap_layout>;
+    using StringColumn =
+        pid::with_layout<std::vector<std::optional<std::string>>, validity_bitmap_layout>;
+
+    std::map<std::string, Column> m_input{
+        {"a", Column{{1, std::nullopt, 3}}}, {"b", Column{{std::nullopt}}}, {"c", Column{}}};
+    const auto & [result, data] = build_helper(m_input);
+
+    const pid32::map32<pid32::string32, pid32::optional_vector32<std::int32_t>> & m = *result;
+
+    REQUIRE(m.size() == 3);
+    REQUIRE(m.at("a").size() == 3);
+    CHECK(m.at("a")[0] == 1);
+    CHECK(not m.at("a")[1]);
+    CHECK(m.at("a")[2] == 3);
+    CHECK(m.at("a").value_count() == 2);
+    REQUIRE(m.at("b").size() == 1);
+    CHECK(not m.at("b")[0]);
+    CHECK(m.at("c").empty());
+
+    // Equal columns in vectors are shared
+    std::vector<std::vector<StringColumn>> v_input{
+        {StringColumn{{"x", std::nullopt}}}, {StringColumn{{"x", std::nullopt}}},
+        {StringColumn{{"x", "y"}}}};
+    const auto & [v_result, v_data] = build_helper(v_input);
+
+    const pid32::vector32<pid32::vector32<pid32::optional_string_vector32>> & v = *v_result;
+
+    REQUIRE(v.size() == 3);
+    REQUIRE(v[0].size() == 1);
+    CHECK(v[0][0][0] == "x");
+    CHECK(not v[0][0][1]);
+    CHECK(v[0].begin() == v[1].begin());
+    CHECK(v[0].begin() != v[2].begin());
+    CHECK(v[2][0][1] == "y");
+}
+
 TEST_CASE("test caching 1")
 {
     std::map<std::string, std::vector<std::optional<std::string>>> m_input{
@@ -258,4 +474,368 @@ TEST_CASE("test caching 1")
     CHECK(&*itA->second.begin() == &*itC->second.begin());
 }
 
-// TODO: deduplication of maps
+TEST_CASE("test caching 2")
+{
+    // Enough distinct values to make the caches grow several times
+    std::vector<std::vector<std::string>> v_input;
+    for (int i{0}; i < 1000; ++i) {
+        v_input.push_back({std::to_string(i % 100), std::to_string(i % 7)});
+    }
+
+    const auto & [result, data] = build_helper(v_input);
+    const pid32::vector32<pid32::vector32<pid32::string32>> & v = *result;
+
+    REQUIRE(v.size() == 1000);
+    for (int i{0}; i < 1000; ++i) {
+        REQUIRE(v[i].size() == 2);
+        CHECK(v[i][0] == std::to_string(i % 100));
+        CHECK(v[i][1] == std::to_string(i % 7));
+
+        // Vectors repeat after 700 items, strings after 100 or 7 items
+        CHECK(v[i].begin() == v[i % 700].begin());
+        CHECK(v[i][0].begin() == v[i % 100][0].begin());
+        CHECK(v[i][1].begin() == v[i % 7][1].begin());
+    }
+}
+
+TEST_CASE("test caching of numbers")
+{
+    // Numbers are compared bitwise, so 0.0 and -0.0 are stored separately
+    std::vector<std::vector<double>> v_input{{0.0, 1.0}, {-0.0, 1.0}, {0.0, 1.0}, {0.0}};
+
+    const auto & [result, data] = build_helper(v_input);
+    const pid32::vector32<pid32::vector32<double>> & v = *result;
+
+    REQUIRE(v.size() == 4);
+    CHECK(v[0].begin() == v[2].begin());
+    CHECK(v[0].begin() != v[1].begin());
+    CHECK(std::signbit(v[1][0]));
+    CHECK(v[3].size() == 1);
+}
+
+TEST_CASE("caches are evicted when data are flushed")
+{
+    const auto path{std::filesystem::temp_directory_path() / "pid-test-flushed-caches.bin"};
+
+    {
+        builder b{builder_storage::streamed_file(path, 1 << 16)};
+        datastructure_builder d_builder{b};
+
+        const std::vector<std::string> input{"a", "b"};
+        const auto first{d_builder(input)};
+        CHECK(d_builder(input).offset == first.offset);
+
+        b.add_vector<char, std::uint32_t>(2 * builder_storage::flush_alignment);
+        b.data.flush(b.data.size());
+        REQUIRE(b.data.flushed_size() > first.offset);
+
+        // The flushed vector and strings cannot be compared anymore, so they are added again
+        const auto second{d_builder(input)};
+        CHECK(second.offset >= b.data.flushed_size());
+        CHECK(d_builder(input).offset == second.offset);
+        CHECK(d_builder(std::string{"a"}).offset >= b.data.flushed_size());
+    }
+
+    std::filesystem::remove(path);
+}
+
+TEST_CASE("build vector of bools")
+{
+    // std::vector<bool> does not store its items contiguously
+    std::vector<std::vector<bool>> v_input{{true, false, true}, {false}, {true, false, true}};
+
+    const auto & [result, data] = build_helper(v_input);
+    const pid32::vector32<pid32::vector32<bool>> & v = *result;
+
+    REQUIRE(v.size() == 3);
+    REQUIRE(v[0].size() == 3);
+    CHECK(v[0][0]);
+    CHECK(not v[0][1]);
+    CHECK(v[0][2]);
+    REQUIRE(v[1].size() == 1);
+    CHECK(not v[1][0]);
+    CHECK(v[0].begin() == v[2].begin());
+    CHECK(v[0].begin() != v[1].begin());
+}
+
+TEST_CASE("build eytzinger map (int -> int)")
+{
+    // Cover complete and incomplete trees of different heights
+    for (std::int32_t n{0}; n < 100; ++n) {
+        std::map<std::int32_t, std::int32_t> m_input;
+        for (std::int32_t i{0}; i < n; ++i) {
+            m_input[2 * i] = -i;
+        }
+
+        const auto & [result, data] = build_map_helper<eytzinger_map_layout>(m_input);
+
+        const pid32::eytzinger_map32<std::int32_t, std::int32_t> & m{*result};
+
+        REQUIRE(m.size() == static_cast<std::uint32_t>(n));
+        for (std::int32_t i{0}; i < n; ++i) {
+            CHECK(m.at(2 * i) == -i);
+            CHECK(m.find(2 * i)->first == 2 * i);
+            CHECK(m.find(2 * i + 1) == m.end());
+        }
+        CHECK(m.find(-1) == m.end());
+    }
+}
+
+TEST_CASE("build s-tree map (int -> int)")
+{
+    for (const std::int32_t n : {0, 1, 16, 17, 300}) {
+        std::map<std::int32_t, std::int32_t> m_input;
+        for (std::int32_t i{0}; i < n; ++i) {
+            m_input[2 * i] = -i;
+        }
+
+        const auto & [result, data] = build_map_helper<s_tree_map_layout>(m_input);
+
+        const pid32::s_tree_map32<std::int32_t, std::int32_t> & m{*result};
+
+        REQUIRE(m.size() == static_cast<std::uint32_t>(n));
+        for (std::int32_t i{0}; i < n; ++i) {
+            CHECK(m.at(2 * i) == -i);
+            CHECK(m.find(2 * i + 1) == m.end());
+        }
+        CHECK(m.find(-1) == m.end());
+    }
+}
+
+TEST_CASE("build eytzinger map (str -> [str])")
+{
+    std::map<std::string, std::vector<std::string>> m_input{
+        {"one", {"1"}}, {"two", {"2", "II"}}, {"three", {}}, {"four", {"4"}}, {"five", {"V"}}};
+    const auto & [result, data] = build_map_helper<eytzinger_map_layout>(m_input);
+
+    const pid32::eytzinger_map32<pid32::string32, pid32::vector32<pid32::string32>> & m =
+        *result;
+
+    REQUIRE(m.size() == 5);
+    CHECK_THROWS_AS(m.at("six"), std::out_of_range);
+    CHECK_THROWS_AS(m.at("a"), std::out_of_range);
+    CHECK_THROWS_AS(m.at("z"), std::out_of_range);
+    REQUIRE(m.at("one").size() == 1);
+    CHECK(m.at("one")[0] == "1");
+    REQUIRE(m.at("two").size() == 2);
+    CHECK(m.at("two")[1] == "II");
+    CHECK(m.at("three").empty());
+    CHECK(m.at("four")[0] == "4");
+    CHECK(m.at("five")[0] == "V");
+
+    // Items are stored in breadth-first order: "three" is the root, "four" and "two" are its
+    // children, and "five" and "one" are the children of "four"
+    CHECK(m.begin()->first == "three");
+    CHECK(m.begin()[1].first == "four");
+    CHECK(m.begin()[2].first == "two");
+    CHECK(m.begin()[3].first == "five");
+    CHECK(m.begin()[4].first == "one");
+}
+
+TEST_CASE("build hash map (int -> int)")
+{
+    for (std::int32_t n : {0, 1, 2, 3, 4, 5, 17, 100, 1000, 100000}) {
+        std::map<std::int32_t, std::int32_t> m_input;
+        for (std::int32_t i{0}; i < n; ++i) {
+            m_input[3 * i - n] = i;
+        }
+
+        const auto & [result, data] = build_map_helper<hash_map_layout>(m_input);
+
+        const pid32::hash_map32<std::int32_t, std::int32_t> & m{*result};
+
+        REQUIRE(m.size() == static_cast<std::uint32_t>(n));
+        for (std::int32_t i{0}; i < n; ++i) {
+            REQUIRE(m.find(3 * i - n) != m.end());
+            CHECK(m.at(3 * i - n) == i);
+            CHECK(m.find(3 * i - n + 1) == m.end());
+        }
+
+        // Every item is stored exactly once
+        CHECK(std::distance(m.begin(), m.end()) == n);
+    }
+}
+
+TEST_CASE("build hash map (str -> [str])")
+{
+    std::map<std::string, std::vector<std::string>> m_input{
+        {"one", {"1"}}, {"two", {"2", "II"}}, {"three", {}}, {"four", {"4"}}, {"five", {"V"}}};
+    const auto & [result, data] = build_map_helper<hash_map_layout>(m_input);
+
+    const pid32::hash_map32<pid32::string32, pid32::vector32<pid32::string32>> & m = *result;
+
+    REQUIRE(m.size() == 5);
+    CHECK_THROWS_AS(m.at("six"), std::out_of_range);
+    CHECK_THROWS_AS(m.at(""), std::out_of_range);
+    REQUIRE(m.at("one").size() == 1);
+    CHECK(m.at("one")[0] == "1");
+    REQUIRE(m.at("two").size() == 2);
+    CHECK(m.at("two")[1] == "II");
+    CHECK(m.at("three").empty());
+    CHECK(m.at(std::string{"four"})[0] == "4");
+    CHECK(m.at(std::string_view{"five"})[0] == "V");
+}
+
+TEST_CASE("build soa map (int -> [int])")
+{
+    std::map<std::int32_t, std::vector<std::int32_t>> m_input{
+        {3, {1, 2, 3}}, {-5, {}}, {10, {4}}, {0, {5, 6}}};
+    const auto & [result, data] = build_map_helper<soa_map_layout>(m_input);
+
+    const pid32::soa_map32<std::int32_t, pid32::vector32<std::int32_t>> & m = *result;
+
+    REQUIRE(m.size() == 4);
+    CHECK_THROWS_AS(m.at(1), std::out_of_range);
+    CHECK(m.find(11) == m.end());
+    CHECK(m.find(-6) == m.end());
+    CHECK(m.at(-5).empty());
+    REQUIRE(m.at(0).size() == 2);
+    CHECK(m.at(0)[1] == 6);
+    REQUIRE(m.at(3).size() == 3);
+    CHECK(m.at(3)[2] == 3);
+    CHECK(m.find(10)->first == 10);
+    CHECK(m.find(10)->second[0] == 4);
+
+    // Keys and values are stored in separate, dense arrays
+    REQUIRE(m.keys().size() == 4);
+    CHECK(m.keys()[0] == -5);
+    CHECK(m.keys()[3] == 10);
+    CHECK(&m.keys()[1] + 1 == &m.keys()[2]);
+
+    // Items are visited in the order of their keys
+    std::vector<std::int32_t> keys;
+    for (const auto & [key, value] : m) {
+        keys.push_back(key);
+    }
+    CHECK(keys == std::vector<std::int32_t>{-5, 0, 3, 10});
+}
+
+TEST_CASE("build soa map (str -> str)")
+{
+    std::map<std::string, std::string> m_input{{"b", "B"}, {"a", "A"}, {"c", "C"}};
+    const auto & [result, data] = build_map_helper<soa_map_layout>(m_input);
+
+    const pid32::soa_map32<pid32::string32, pid32::string32> & m = *result;
+
+    REQUIRE(m.size() == 3);
+    CHECK(m.at("a") == "A");
+    CHECK(m.at("b") == "B");
+    CHECK(m.at("c") == "C");
+    CHECK(m.find("d") == m.end());
+    CHECK(m.find("c") - m.begin() == 2);
+}
+
+TEST_CASE("deduplication of soa maps")
+{
+    using MapType = pid32::soa_map32<pid32::string32, std::int32_t>;
+
+    const std::map<std::string, std::int32_t> first{{"a", 1}, {"b", 2}};
+    const std::map<std::string, std::int32_t> second{{"a", 3}, {"b", 4}};
+
+    pid::builder b;
+    pid::datastructure_builder d_builder{b};
+
+    const auto first_items{d_builder(first, soa_map_layout{})};
+    const std::size_t size{b.data.size()};
+
+    // Only the values of the second map are added
+    using ValuesDataType = detail::generic_vector_data<std::int32_t, std::uint32_t>;
+    const auto second_items{d_builder(second, soa_map_layout{})};
+    CHECK(second_items.keys.offset == first_items.keys.offset);
+    CHECK(
+        b.data.size() - size
+        < sizeof(ValuesDataType) + 2 * sizeof(std::int32_t) + alignof(ValuesDataType));
+
+    // Both vectors of the third map are shared
+    const std::size_t second_size{b.data.size()};
+    const auto third_items{d_builder(first, soa_map_layout{})};
+    CHECK(third_items.keys.offset == first_items.keys.offset);
+    CHECK(third_items.values.offset == first_items.values.offset);
+    CHECK(b.data.size() == second_size);
+
+    auto first_map{b.add<MapType>()};
+    *first_map = first_items;
+    auto second_map{b.add<MapType>()};
+    *second_map = second_items;
+
+    CHECK(first_map->at("b") == 2);
+    CHECK(second_map->at("a") == 3);
+    CHECK(second_map->at("b") == 4);
+}
+
+TEST_CASE("deduplication of maps")
+{
+    using InnerMap = std::map<std::string, std::vector<std::int32_t>>;
+
+    const InnerMap inner_a{{"x", {1, 2}}, {"y", {3}}};
+    const InnerMap inner_b{{"x", {1, 2}}, {"y", {4}}};
+
+    std::map<std::string, InnerMap> m_input{
+        {"a1", inner_a}, {"b", inner_b}, {"a2", inner_a}, {"empty1", {}}, {"empty2", {}}};
+
+    const auto & [result, data] = build_helper(m_input);
+
+    const pid32::map32<
+        pid32::string32, pid32::map32<pid32::string32, pid32::vector32<std::int32_t>>> & m =
+        *result;
+
+    REQUIRE(m.size() == 5);
+    CHECK(m.at("a1").at("x").size() == 2);
+    CHECK(m.at("a2").at("y")[0] == 3);
+    CHECK(m.at("b").at("y")[0] == 4);
+
+    // Identical maps are stored once, and maps which share items are not mixed up
+    CHECK(m.at("a1").begin() == m.at("a2").begin());
+    CHECK(m.at("a1").begin() != m.at("b").begin());
+    CHECK(m.at("empty1").begin() == m.at("empty2").begin());
+
+    // The vector {1, 2} is shared by all inner maps
+    CHECK(m.at("a1").at("x").begin() == m.at("b").at("x").begin());
+
+    CHECK_NOTHROW(verify<std::remove_cvref_t<decltype(m)>>(
+        data, static_cast<std::size_t>(reinterpret_cast<const char *>(&m) - data.data())));
+}
+
+TEST_CASE("deduplication of maps removes their data")
+{
+    const std::map<std::string, std::string> inner{{"key", "value"}, {"other key", "value"}};
+
+    const auto & [result_1, data_1] = build_helper(std::vector{inner});
+    const auto & [result_2, data_2] = build_helper(std::vector{inner, inner, inner});
+
+    CHECK(result_1->size() == 1);
+    CHECK(result_2->size() == 3);
+
+    // Only the map handles in the outer vector are added
+    using MapType = pid32::map32<pid32::string32, pid32::string32>;
+    CHECK(data_2.size() <= data_1.size() + 2 * sizeof(MapType));
+}
+
+TEST_CASE("deduplication of optionals")
+{
+    std::vector<std::optional<std::string>> v_input{"x", std::nullopt, "x", "y"};
+    const auto & [result, data] = build_helper(v_input);
+
+    const pid32::vector32<pid32::ptr<pid32::string32>> & v = *result;
+
+    REQUIRE(v.size() == 4);
+    CHECK(not v[1]);
+    CHECK(&*v[0] == &*v[2]);
+    CHECK(&*v[0] != &*v[3]);
+    CHECK(*v[3] == "y");
+}
+
+TEST_CASE("build vector of optional vectors")
+{
+    std::vector<std::optional<std::vector<std::int32_t>>> v_input{
+        std::vector<std::int32_t>{1, 2}, std::nullopt, std::vector<std::int32_t>{1, 2}};
+    const auto & [result, data] = build_helper(v_input);
+
+    const pid32::vector32<pid32::ptr<pid32::vector32<std::int32_t>>> & v = *result;
+
+    REQUIRE(v.size() == 3);
+    CHECK(not v[1]);
+    REQUIRE(v[0]);
+    CHECK(v[0]->size() == 2);
+    CHECK(&*v[0] == &*v[2]);
+}
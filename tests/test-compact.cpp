@@ -0,0 +1,407 @@
+#include <pid/compact.h>
+#include <pid/verify.h>
+
+#include "catch.hpp"
+
+#include <string>
+#include <vector>
+
+using namespace pid;
+
+namespace {
+    struct small
+    {
+        pid8::ptr<std::int32_t> a;
+    };
+
+    struct pair_of_strings
+    {
+        pid::string first;
+        pid::string second;
+    };
+
+    struct document
+    {
+        pid::string title;
+        pid::vector<pid::string> names;
+        pid::map<pid::string, std::int32_t> index;
+        std::optional<pid::string> comment;
+    };
+
+    struct tree
+    {
+        pid::ptr<tree> left;
+        pid::ptr<tree> right;
+        std::int32_t value;
+    };
+}
+
+template <>
+struct pid::struct_members<small>
+{
+    static constexpr auto members{std::make_tuple(&small::a)};
+};
+
+template <>
+struct pid::struct_members<pair_of_strings>
+{
+    static constexpr auto members{
+        std::make_tuple(&pair_of_strings::first, &pair_of_strings::second)};
+};
+
+template <>
+struct pid::struct_members<document>
+{
+    static constexpr auto members{std::make_tuple(
+        &document::title, &document::names, &document::index, &document::comment)};
+};
+
+template <>
+struct pid::struct_members<tree>
+{
+    static constexpr auto members{std::make_tuple(&tree::left, &tree::right, &tree::value)};
+};
+
+namespace {
+    template <typename T>
+    const T & root_of(const builder & b, std::size_t offset)
+    {
+        return *reinterpret_cast<const T *>(b.data.data() + offset);
+    }
+}
+
+TEST_CASE("compaction drops unreachable objects")
+{
+    builder b;
+
+    {
+        auto root{b.add<small>()};
+
+        // Only the last value stays reachable
+        for (std::int32_t i{0}; i < 30; ++i) {
+            auto value{b.add<std::int32_t>()};
+            *value = i;
+            root->a = value;
+        }
+    }
+
+    const std::vector<char> data{b.data.begin(), b.data.end()};
+
+    builder compacted;
+    const auto root{compact<small>(data, 0, compacted)};
+
+    CHECK(compacted.data.size() == 2 * sizeof(std::int32_t));
+    CHECK(compacted.data.size() < data.size());
+    CHECK(*root->a == 29);
+}
+
+TEST_CASE("compaction shares equal strings")
+{
+    builder b;
+
+    {
+        auto root{b.add<pair_of_strings>()};
+        root->first = b.add_string("a string which is stored twice");
+        root->second = b.add_string("a string which is stored twice");
+    }
+
+    const std::vector<char> data{b.data.begin(), b.data.end()};
+
+    builder compacted;
+    const auto root_offset{compact<pair_of_strings>(data, 0, compacted).offset};
+    const auto & root{root_of<pair_of_strings>(compacted, root_offset)};
+
+    CHECK(compacted.data.size() < data.size());
+    CHECK(root.first == "a string which is stored twice");
+    CHECK(root.first.begin() == root.second.begin());
+    CHECK_NOTHROW(verify<pair_of_strings>(
+        std::span<const char>{compacted.data.data(), compacted.data.size()}, root_offset));
+}
+
+TEST_CASE("compaction shares equal hashed strings")
+{
+    using PairType = std::pair<pid::hashed_string, pid::hashed_string>;
+
+    builder b;
+
+    // Leave non-zero bytes behind the end of the data, which must not end up in the strings
+    for (int i{0}; i < 8; ++i) {
+        *b.add<std::uint64_t>() = ~std::uint64_t{0};
+    }
+    b.data.resize(0);
+
+    {
+        auto root{b.add<PairType>()};
+        root->first = b.add_hashed_string("a string which is stored twice");
+        root->second = b.add_hashed_string("a string which is stored twice");
+    }
+
+    const std::vector<char> data{b.data.begin(), b.data.end()};
+
+    builder compacted;
+    const auto root{compact<PairType>(data, 0, compacted)};
+
+    CHECK(compacted.data.size() < data.size());
+    CHECK(root->first == "a string which is stored twice");
+    CHECK(root->first.begin() == root->second.begin());
+}
+
+TEST_CASE("compaction of nested data structures")
+{
+    builder b;
+
+    {
+        auto root{b.add<document>()};
+        root->title = b.add_string("title");
+        b.add_string("unused");
+
+        auto names{b.add_vector<pid::string, std::uint32_t>(3)};
+        root->names = names;
+        (*names)[0] = b.add_string("a");
+        (*names)[1] = b.add_string("b");
+        (*names)[2] = b.add_string("a");
+        b.add_vector<std::int64_t, std::uint32_t>(100);
+
+        auto index{b.add_map<pid::string, std::int32_t, std::uint32_t>(2)};
+        root->index = index.items;
+        *index.add_key(b.add_string("a")) = 1;
+        *index.add_key(b.add_string("b")) = 2;
+
+        root->comment = b.add_string("title");
+    }
+
+    const std::vector<char> data{b.data.begin(), b.data.end()};
+
+    builder compacted;
+    compacted.add<std::uint8_t>();
+    const auto root_offset{compact<document>(data, 0, compacted).offset};
+    const std::span<const char> result{compacted.data.data(), compacted.data.size()};
+
+    CHECK(result.size() < data.size());
+    CHECK_NOTHROW(verify<document>(result, root_offset));
+
+    const auto & root{root_of<document>(compacted, root_offset)};
+    CHECK(root.title == "title");
+    CHECK(root.comment->begin() == root.title.begin());
+    REQUIRE(root.names.size() == 3);
+    CHECK(root.names[0] == "a");
+    CHECK(root.names[1] == "b");
+    CHECK(root.names[0].begin() == root.names[2].begin());
+    CHECK(root.index.find("a")->second == 1);
+    CHECK(root.index.find("b")->second == 2);
+}
+
+TEST_CASE("compaction of a pointer into a vector")
+{
+    builder b;
+
+    {
+        auto root{b.add<small>()};
+        auto values{b.add_vector<std::int32_t, std::uint8_t>(4)};
+        for (std::int32_t i{0}; i < 4; ++i) {
+            (*values)[static_cast<std::size_t>(i)] = i;
+        }
+
+        // The vector is kept as a whole, because the pointer points into it
+        root->a = b.convert_to_builder_offset(&(*values)[2]);
+    }
+
+    const std::vector<char> data{b.data.begin(), b.data.end()};
+
+    builder compacted;
+    const auto root{compact<small>(data, 0, compacted)};
+
+    CHECK(*root->a == 2);
+}
+
+TEST_CASE("compact blob")
+{
+    builder b;
+
+    {
+        auto header{add_blob_header(b)};
+        auto root{b.add<pair_of_strings>()};
+        b.add_string("unused");
+        root->first = b.add_string("first");
+        root->second = b.add_string("second");
+        finish_blob(header, root);
+    }
+
+    const std::vector<char> data{b.data.begin(), b.data.end()};
+
+    builder compacted;
+    compact_blob<pair_of_strings>(data, compacted);
+
+    const std::vector<char> result{compacted.data.begin(), compacted.data.end()};
+    CHECK(result.size() < data.size());
+
+    const auto & root{open_verified_blob<pair_of_strings>(result)};
+    CHECK(root.first == "first");
+    CHECK(root.second == "second");
+}
+
+TEST_CASE("compaction keeps search trees aligned to cache lines")
+{
+    using MapType = pid::s_tree_map<std::int32_t, std::int32_t>;
+    using IndexDataType = detail::generic_s_tree_data<std::int32_t, std::uint32_t>;
+
+    builder b;
+
+    {
+        auto root{b.add<MapType>()};
+        b.add_string("unused");
+        auto map{b.add_s_tree_map<std::int32_t, std::int32_t, std::uint32_t>(100)};
+        *root = map.offset();
+        for (std::int32_t i{0}; i < 100; ++i) {
+            *map.add_key(2 * i) = i;
+        }
+    }
+
+    const std::vector<char> data{b.data.begin(), b.data.end()};
+
+    // Moves the map by numbers of bytes which are not multiples of the cache line size
+    for (std::size_t words{0}; words < 8; ++words) {
+        builder compacted;
+        for (std::size_t i{0}; i < words; ++i) {
+            compacted.add<std::uint64_t>();
+        }
+
+        const auto root{compact<MapType>(data, 0, compacted)};
+        CHECK(root->at(20) == 10);
+        CHECK(root->find(21) == root->end());
+
+        const detail::object_graph graph{
+            {compacted.data.data(), compacted.data.size()}, root.offset,
+            object_type_of<MapType>};
+        const auto index{
+            std::find_if(graph.nodes.begin(), graph.nodes.end(), [](const auto & node) {
+                return node.type == &object_type_of<IndexDataType>;
+            })};
+        REQUIRE(index != graph.nodes.end());
+
+        const auto & index_data{root_of<IndexDataType>(compacted, index->offset)};
+        const auto keys{
+            reinterpret_cast<const char *>(index_data.keys()) - compacted.data.data()};
+        CHECK(keys % IndexDataType::cache_line_size == 0);
+    }
+}
+
+namespace {
+    // Builds a complete binary tree with 'depth' levels, whose nodes are added to the builder
+    // in the reverse order of their values. The values are assigned in depth-first order.
+    builder_offset<tree> add_tree(builder & b, std::int32_t depth, std::int32_t & value)
+    {
+        if (depth == 0) {
+            return builder_offset<tree>{b};
+        }
+
+        const std::int32_t own_value{value++};
+        auto left{add_tree(b, depth - 1, value)};
+        auto right{add_tree(b, depth - 1, value)};
+
+        auto result{b.add<tree>()};
+        result->value = own_value;
+        if (left.valid) {
+            result->left = left;
+            result->right = right;
+        }
+        return result;
+    }
+
+    // Returns the values of the nodes in the order in which they are stored
+    std::vector<std::int32_t> stored_values(const builder & b, std::size_t root_offset)
+    {
+        std::vector<std::pair<const tree *, std::int32_t>> nodes;
+        std::vector<const tree *> stack{&root_of<tree>(b, root_offset)};
+        while (not stack.empty()) {
+            const tree * t{stack.back()};
+            stack.pop_back();
+            nodes.emplace_back(t, t->value);
+            if (t->left) {
+                stack.push_back(&*t->left);
+                stack.push_back(&*t->right);
+            }
+        }
+
+        std::sort(nodes.begin(), nodes.end());
+        std::vector<std::int32_t> result;
+        for (const auto & [t, value] : nodes) {
+            result.push_back(value);
+        }
+        return result;
+    }
+}
+
+TEST_CASE("relayout of a tree")
+{
+    builder b;
+    std::int32_t value{0};
+    const std::size_t root_offset{add_tree(b, 3, value).offset};
+
+    const std::vector<char> data{b.data.begin(), b.data.end()};
+    CHECK(stored_values(b, root_offset) == std::vector<std::int32_t>{2, 3, 1, 5, 6, 4, 0});
+
+    {
+        builder compacted;
+        const auto root{compact<tree>(data, root_offset, compacted, layout_order::depth_first)};
+        CHECK(root.offset == 0);
+        CHECK(stored_values(compacted, 0) == std::vector<std::int32_t>{0, 1, 2, 3, 4, 5, 6});
+    }
+
+    {
+        builder compacted;
+        compact<tree>(data, root_offset, compacted, layout_order::breadth_first);
+        CHECK(stored_values(compacted, 0) == std::vector<std::int32_t>{0, 1, 4, 2, 3, 5, 6});
+    }
+
+    {
+        builder compacted;
+        const auto root{compact<tree>(data, root_offset, compacted, layout_order::original)};
+        CHECK(stored_values(compacted, root.offset) == stored_values(b, root_offset));
+    }
+}
+
+TEST_CASE("relayout stores keys next to map items")
+{
+    using MapType = pid::map<pid::string, pid::vector<std::int32_t>>;
+    constexpr std::uint32_t size{100};
+
+    builder b;
+
+    {
+        auto root{b.add<MapType>()};
+        auto map{b.add_map<pid::string, pid::vector<std::int32_t>, std::uint32_t>(size)};
+        *root = map.items;
+
+        for (std::uint32_t i{0}; i < size; ++i) {
+            auto value{map.add_key(b.add_string("key " + std::to_string(1000 + i)))};
+            auto values{b.add_vector<std::int32_t, std::uint32_t>(10)};
+            *value = values;
+            (*values)[0] = static_cast<std::int32_t>(i);
+        }
+    }
+
+    const std::vector<char> data{b.data.begin(), b.data.end()};
+
+    for (const auto order : {
+             layout_order::original, layout_order::depth_first, layout_order::breadth_first,
+             layout_order::leaves_first}) {
+        builder compacted;
+        const auto root_offset{compact<MapType>(data, 0, compacted, order).offset};
+        const std::span<const char> result{compacted.data.data(), compacted.data.size()};
+        CHECK_NOTHROW(verify<MapType>(result, root_offset));
+
+        const auto & map{root_of<MapType>(compacted, root_offset)};
+        REQUIRE(map.size() == size);
+        CHECK(map.find("key 1042")->second[0] == 42);
+
+        // Only leaves_first stores all keys directly after the items
+        const char * const items_end{reinterpret_cast<const char *>(map.end())};
+        const auto keys_end{map.end()[-1].first.end() - items_end};
+        if (order == layout_order::leaves_first) {
+            CHECK(keys_end < static_cast<std::ptrdiff_t>(size * 16));
+        } else {
+            CHECK(keys_end > static_cast<std::ptrdiff_t>(size * 16));
+        }
+    }
+}
@@ -0,0 +1,160 @@
+#include <pid/mapped-blob.h>
+
+#include "catch.hpp"
+
+#include <filesystem>
+#include <fstream>
+
+using namespace pid;
+
+namespace {
+    struct root
+    {
+        pid::string name;
+        pid::vector<std::int32_t> numbers;
+    };
+
+    std::string build_blob_file(const std::string & file_name)
+    {
+        const auto path{(std::filesystem::temp_directory_path() / file_name).string()};
+
+        builder b{builder_storage::mapped_file(path)};
+
+        auto header{add_blob_header(b)};
+        auto offset_root{b.add<root>()};
+
+        offset_root->name = b.add_string("numbers");
+
+        auto numbers{b.add_vector<std::int32_t, std::uint32_t>(3)};
+        offset_root->numbers = numbers;
+        (*numbers)[0] = 1;
+        (*numbers)[1] = 2;
+        (*numbers)[2] = 3;
+
+        finish_blob(header, offset_root);
+        b.data.close();
+
+        return path;
+    }
+}
+
+TEST_CASE("open mapped blob")
+{
+    const auto path{build_blob_file("pid-test-mapped-blob.bin")};
+
+    {
+        mapped_blob<root> blob{path};
+
+        CHECK(blob->name == "numbers");
+        REQUIRE(blob->numbers.size() == 3);
+        CHECK(blob->numbers[0] == 1);
+        CHECK(blob->numbers[1] == 2);
+        CHECK(blob->numbers[2] == 3);
+
+        // The root is not copied, it refers to the mapped data
+        CHECK(reinterpret_cast<const char *>(&blob.root()) > blob.data().data());
+        CHECK(
+            reinterpret_cast<const char *>(&blob.root())
+            < blob.data().data() + blob.data().size());
+
+        // The blob can be moved without invalidating the root reference
+        const root & r{*blob};
+        const mapped_blob<root> moved{std::move(blob)};
+        CHECK(&moved.root() == &r);
+    }
+
+    std::filesystem::remove(path);
+}
+
+TEST_CASE("reject invalid blobs")
+{
+    const auto path{build_blob_file("pid-test-invalid-blob.bin")};
+
+    std::vector<char> data;
+    {
+        std::ifstream file{path, std::ios::binary};
+        data.assign(std::istreambuf_iterator<char>{file}, std::istreambuf_iterator<char>{});
+    }
+    std::filesystem::remove(path);
+
+    // std::vector data is sufficiently aligned for the header
+    CHECK(open_blob<root>(data).name == "numbers");
+
+    SECTION("wrong root type")
+    {
+        CHECK_THROWS_AS(open_blob<pid::string>(data), std::invalid_argument);
+    }
+
+    SECTION("truncated blob")
+    {
+        CHECK_THROWS_AS(
+            open_blob<root>(std::span<const char>{data.data(), data.size() - 1}),
+            std::invalid_argument);
+        CHECK_THROWS_AS(
+            open_blob<root>(std::span<const char>{data.data(), sizeof(blob_header) - 1}),
+            std::invalid_argument);
+    }
+
+    SECTION("corrupted magic")
+    {
+        data[0] = 'X';
+        CHECK_THROWS_AS(open_blob<root>(data), std::invalid_argument);
+    }
+
+    SECTION("corrupted root offset")
+    {
+        reinterpret_cast<blob_header *>(data.data())->root_offset = data.size();
+        CHECK_THROWS_AS(open_blob<root>(data), std::invalid_argument);
+    }
+
+    SECTION("missing file")
+    {
+        CHECK_THROWS_AS(mapped_blob<root>{path}, std::system_error);
+    }
+}
+
+TEST_CASE("blob header must come first")
+{
+    builder b;
+    b.add<std::int32_t>();
+
+    CHECK_THROWS_AS(add_blob_header(b), std::logic_error);
+}
+
+TEST_CASE("open streamed blob")
+{
+    const auto path{
+        (std::filesystem::temp_directory_path() / "pid-test-streamed-blob.bin").string()};
+
+    {
+        builder b{builder_storage::streamed_file(path, 1 << 16)};
+
+        auto header{add_blob_header(b)};
+        auto offset_root{b.add<root>()};
+        offset_root->name = b.add_string("numbers");
+        b.add_vector<char, std::uint32_t>(2 * builder_storage::flush_alignment);
+        b.data.flush(b.data.size());
+        REQUIRE(b.data.flushed_size() > offset_root.offset);
+
+        // The header and the root have been written to the file already
+        auto numbers{b.add_vector<std::int32_t, std::uint32_t>(3)};
+        (*numbers)[2] = 3;
+        CHECK_THROWS_AS(offset_root->numbers = numbers, std::logic_error);
+
+        auto offset_copy{b.add<root>()};
+        offset_copy->name = b.add_string("copy");
+        offset_copy->numbers = numbers;
+
+        finish_blob(header, offset_copy);
+        b.data.close();
+    }
+
+    {
+        mapped_blob<root> blob{path};
+        CHECK(blob->name == "copy");
+        REQUIRE(blob->numbers.size() == 3);
+        CHECK(blob->numbers[2] == 3);
+    }
+
+    std::filesystem::remove(path);
+}
@@ -0,0 +1,99 @@
+#include <pid/offset-width.h>
+
+#include "catch.hpp"
+
+#include <vector>
+
+using namespace pid;
+
+namespace {
+    template <typename OffsetType>
+    struct record
+    {
+        pid::detail::ptr<std::int64_t, OffsetType> value;
+        pid::detail::ptr<record, OffsetType> next;
+    };
+}
+
+template <typename OffsetType>
+struct pid::struct_members<record<OffsetType>>
+{
+    static constexpr auto members{
+        std::make_tuple(&record<OffsetType>::value, &record<OffsetType>::next)};
+};
+
+namespace {
+    // Adds a record whose value is stored behind 'distance' unused bytes
+    template <typename OffsetType>
+    builder_offset<record<OffsetType>> add_record(builder & b, std::size_t distance)
+    {
+        auto result{b.add<record<OffsetType>>()};
+        b.add_vector<char, std::uint64_t>(distance);
+
+        auto value{b.add<std::int64_t>()};
+        *value = static_cast<std::int64_t>(distance);
+        result->value = value;
+        return result;
+    }
+
+    template <typename OffsetType>
+    std::size_t required_size(std::size_t distance)
+    {
+        builder b;
+        add_record<OffsetType>(b, distance);
+        return required_offset_size<record<OffsetType>>(
+            std::span<const char>{b.data.data(), b.data.size()}, 0);
+    }
+
+    std::size_t narrowest_size(std::size_t distance)
+    {
+        builder b;
+        const std::size_t result{build_with_narrowest_offsets(b, [&](builder & b, auto type) {
+            using OffsetType = typename decltype(type)::type;
+            auto first{add_record<OffsetType>(b, 10)};
+            first->next = add_record<OffsetType>(b, distance);
+        })};
+
+        // The failed attempts have been removed
+        CHECK(b.data.size() < 2 * distance + 100);
+        return result;
+    }
+}
+
+TEST_CASE("required offset size")
+{
+    CHECK(required_size<std::int64_t>(0) == 1);
+    CHECK(required_size<std::int64_t>(50) == 1);
+    CHECK(required_size<std::int64_t>(1000) == 2);
+    CHECK(required_size<std::int64_t>(100000) == 4);
+    CHECK(required_size<std::int32_t>(100000) == 4);
+
+    {
+        builder b;
+        b.add<record<std::int64_t>>();
+        CHECK(required_offset_size<record<std::int64_t>>(
+                  std::span<const char>{b.data.data(), b.data.size()}, 0)
+              == 1);
+    }
+}
+
+TEST_CASE("build with narrowest offsets")
+{
+    CHECK(narrowest_size(50) == 1);
+    CHECK(narrowest_size(1000) == 2);
+    CHECK(narrowest_size(100000) == 4);
+
+    builder b;
+    const std::size_t size{build_with_narrowest_offsets(
+        b,
+        [](builder & b, auto type) {
+            using OffsetType = typename decltype(type)::type;
+            CHECK(sizeof(OffsetType) >= 2);
+            add_record<OffsetType>(b, 10);
+        },
+        2)};
+    CHECK(size == 2);
+
+    const auto & root{*reinterpret_cast<const record<std::int16_t> *>(b.data.data())};
+    CHECK(*root.value == 10);
+}
@@ -0,0 +1,374 @@
+#include <pid/verify.h>
+
+#include "catch.hpp"
+
+#include <string>
+#include <vector>
+
+using namespace pid;
+
+namespace {
+    struct record
+    {
+        pid::string name;
+        pid::vector<std::int32_t> values;
+    };
+
+    struct document
+    {
+        pid::string title;
+        pid::vector<record> records;
+        pid::map<pid::string, std::int32_t> index;
+        pid::hash_map<pid::string, std::int32_t> hashes;
+        std::optional<pid::string> comment;
+        pid::ptr<std::int64_t> number;
+    };
+
+    struct node
+    {
+        pid::ptr<node> next;
+        std::int32_t value;
+    };
+}
+
+template <>
+struct pid::struct_members<record>
+{
+    static constexpr auto members{std::make_tuple(&record::name, &record::values)};
+};
+
+template <>
+struct pid::struct_members<document>
+{
+    static constexpr auto members{std::make_tuple(
+        &document::title, &document::records, &document::index, &document::hashes,
+        &document::comment, &document::number)};
+};
+
+template <>
+struct pid::struct_members<node>
+{
+    static constexpr auto members{std::make_tuple(&node::next, &node::value)};
+};
+
+namespace {
+    std::vector<char> build_document(std::uint32_t record_count)
+    {
+        builder b;
+
+        auto root{b.add<document>()};
+        root->title = b.add_string("title");
+        root->number = b.add<std::int64_t>();
+
+        auto records{b.add_vector<record, std::uint32_t>(record_count)};
+        root->records = records;
+        const auto shared_name{b.add_string("shared")};
+        for (std::uint32_t i{0}; i < record_count; ++i) {
+            // Half of the records share their name
+            if (i % 2 == 0) {
+                (*records)[i].name = shared_name;
+            } else {
+                (*records)[i].name = b.add_string("record " + std::to_string(i));
+            }
+
+            auto values{b.add_vector<std::int32_t, std::uint32_t>(i % 5)};
+            (*records)[i].values = values;
+        }
+
+        auto index{b.add_map<pid::string, std::int32_t, std::uint32_t>(2)};
+        root->index = index.items;
+        *index.add_key(b.add_string("a")) = 1;
+        *index.add_key(b.add_string("b")) = 2;
+
+        const std::vector<std::string> keys{"x", "y", "z"};
+        auto hashes{b.add_hash_map<pid::string, std::int32_t, std::uint32_t>(keys)};
+        root->hashes = hashes.offset();
+        for (const auto & key : keys) {
+            *hashes.add_key(b.add_string(key)) = 0;
+        }
+
+        root->comment = b.add_string("comment");
+
+        return {b.data.begin(), b.data.end()};
+    }
+
+    const document & as_document(const std::vector<char> & data)
+    {
+        return *reinterpret_cast<const document *>(data.data());
+    }
+
+    std::size_t offset_in(const std::vector<char> & data, const void * p)
+    {
+        return static_cast<std::size_t>(static_cast<const char *>(p) - data.data());
+    }
+}
+
+TEST_CASE("verify valid blob")
+{
+    const auto data{build_document(100)};
+
+    CHECK_NOTHROW(verify<document>(data, 0));
+    CHECK_NOTHROW(verify<document>(data, 0, 4));
+}
+
+TEST_CASE("verify pointer outside of the blob")
+{
+    auto data{build_document(10)};
+    auto & title{*reinterpret_cast<std::int32_t *>(data.data() + offsetof(document, title))};
+
+    title = static_cast<std::int32_t>(data.size());
+    CHECK_THROWS_AS(verify<document>(data, 0), std::invalid_argument);
+
+    title = -1;
+    CHECK_THROWS_AS(verify<document>(data, 0), std::invalid_argument);
+}
+
+TEST_CASE("verify truncated blob")
+{
+    auto data{build_document(10)};
+
+    // The last object is the comment string
+    data.resize(data.size() - 1);
+    CHECK_THROWS_AS(verify<document>(data, 0), std::invalid_argument);
+
+    CHECK_THROWS_AS(verify<document>(data, data.size()), std::invalid_argument);
+}
+
+TEST_CASE("verify vector length")
+{
+    auto data{build_document(10)};
+    const auto & records{as_document(data).records};
+
+    auto & length{*reinterpret_cast<std::uint32_t *>(
+        data.data() + offset_in(data, records.begin()) - sizeof(std::uint32_t))};
+    REQUIRE(length == 10);
+
+    length = 0xffffffff;
+    CHECK_THROWS_AS(verify<document>(data, 0), std::invalid_argument);
+}
+
+TEST_CASE("verify string terminator")
+{
+    auto data{build_document(10)};
+    const std::size_t terminator{offset_in(data, as_document(data).title.end())};
+    REQUIRE(data[terminator] == 0);
+
+    data[terminator] = 'x';
+
+    try {
+        verify<document>(data, 0);
+        FAIL("verification should fail");
+    } catch (const std::invalid_argument & e) {
+        CHECK(std::string{e.what()}.starts_with("string is not NUL-terminated"));
+    }
+}
+
+TEST_CASE("verify shared string in parallel")
+{
+    auto data{build_document(10000)};
+    const auto & records{as_document(data).records};
+
+    // The name of record 0 is shared with all records with an even index
+    data[offset_in(data, records[0].name.end())] = 'x';
+
+    CHECK_THROWS_AS(verify<document>(data, 0, 4), std::invalid_argument);
+}
+
+TEST_CASE("verify string hash")
+{
+    builder b;
+
+    {
+        auto root{b.add<pid::hashed_string>()};
+        *root = b.add_hashed_string("hashed");
+    }
+
+    std::vector<char> data{b.data.begin(), b.data.end()};
+    CHECK_NOTHROW(verify<pid::hashed_string>(data, 0));
+
+    const auto & s{*reinterpret_cast<const pid::hashed_string *>(data.data())};
+    data[offset_in(data, s.begin())] = 'H';
+
+    CHECK_THROWS_AS(verify<pid::hashed_string>(data, 0), std::invalid_argument);
+}
+
+TEST_CASE("verify compressed string vector")
+{
+    builder b;
+
+    {
+        auto root{b.add<pid::compressed_string_vector>()};
+        *root = b.add_compressed_string_vector<std::uint32_t>(
+            std::vector<std::string>{"compressed", "strings", "compressed strings"});
+    }
+
+    std::vector<char> data{b.data.begin(), b.data.end()};
+    CHECK_NOTHROW(verify<pid::compressed_string_vector>(data, 0));
+
+    // A symbol code which is not in the table
+    const auto & v{*reinterpret_cast<const pid::compressed_string_vector *>(data.data())};
+    data[offset_in(data, v.compressed(2).data())] = static_cast<char>(254);
+    CHECK_THROWS_AS(verify<pid::compressed_string_vector>(data, 0), std::invalid_argument);
+}
+
+TEST_CASE("verify encoding of compressed strings")
+{
+    using DataType = detail::generic_compressed_string_vector_data<std::uint32_t>;
+
+    builder b;
+
+    // Both strings are "aa", but the second one is not encoded with the longest symbol
+    {
+        auto root{b.add<pid::compressed_string_vector>()};
+        auto strings{b.add<DataType>(DataType::extra_bytes(2, 2, 3))};
+        strings->vector_length = 2;
+        strings->symbol_count = 2;
+        strings->offsets[1] = 1;
+        strings->offsets[2] = 3;
+        std::memcpy(strings->symbols(), "aa", 2);
+        std::memcpy(strings->symbols() + DataType::max_symbol_length, "a", 1);
+        strings->symbol_lengths()[0] = 2;
+        strings->symbol_lengths()[1] = 1;
+        strings->codes()[1] = 1;
+        strings->codes()[2] = 1;
+        *root = strings;
+    }
+
+    std::vector<char> data{b.data.begin(), b.data.end()};
+    const auto & v{*reinterpret_cast<const pid::compressed_string_vector *>(data.data())};
+    CHECK(v[0] == v[1]);
+    CHECK(not v.equal(0, 1));
+    CHECK_THROWS_AS(verify<pid::compressed_string_vector>(data, 0), std::invalid_argument);
+}
+
+TEST_CASE("verify s-tree map")
+{
+    using MapType = pid::s_tree_map<std::int32_t, std::int32_t>;
+
+    builder b;
+
+    {
+        auto root{b.add<MapType>()};
+        auto map{b.add_s_tree_map<std::int32_t, std::int32_t, std::uint32_t>(100)};
+        *root = map.offset();
+        for (std::int32_t i{0}; i < 100; ++i) {
+            *map.add_key(2 * i) = i;
+        }
+    }
+
+    std::vector<char> data{b.data.begin(), b.data.end()};
+    CHECK_NOTHROW(verify<MapType>(data, 0));
+
+    // The keys stay sorted, but the search tree does not match them anymore
+    const auto & map{*reinterpret_cast<const MapType *>(data.data())};
+    const std::size_t key{offset_in(data, &map.find(20)->first)};
+    ++*reinterpret_cast<std::int32_t *>(data.data() + key);
+
+    CHECK_THROWS_AS(verify<MapType>(data, 0), std::invalid_argument);
+}
+
+TEST_CASE("verify alignment")
+{
+    auto data{build_document(10)};
+    auto & number{*reinterpret_cast<std::int32_t *>(data.data() + offsetof(document, number))};
+    ++number;
+
+    try {
+        verify<document>(data, 0);
+        FAIL("verification should fail");
+    } catch (const std::invalid_argument & e) {
+        CHECK(std::string{e.what()}.starts_with("object is not aligned"));
+    }
+}
+
+TEST_CASE("verify map order")
+{
+    using MapType = pid::map<pid::string, std::int32_t>;
+
+    builder b;
+
+    {
+        auto map{b.add<MapType>()};
+        auto items{b.add_vector<MapType::ItemType, std::uint32_t>(2)};
+        *map = items;
+
+        (*items)[0].first = b.add_string("b");
+        (*items)[1].first = b.add_string("a");
+    }
+
+    const std::vector<char> data{b.data.begin(), b.data.end()};
+
+    try {
+        verify<MapType>(data, 0);
+        FAIL("verification should fail");
+    } catch (const std::invalid_argument & e) {
+        CHECK(std::string{e.what()} == "map keys are not sorted at offset 0");
+    }
+}
+
+TEST_CASE("verify hash map positions")
+{
+    using MapType = pid::hash_map<std::int32_t, std::int32_t>;
+
+    builder b;
+
+    {
+        const std::vector<std::int32_t> keys{1, 2, 3, 4, 5, 6, 7, 8};
+
+        auto map{b.add<MapType>()};
+        auto map_builder{b.add_hash_map<std::int32_t, std::int32_t, std::uint32_t>(keys)};
+        *map = map_builder.offset();
+
+        for (const auto key : keys) {
+            *map_builder.add_key(key) = key;
+        }
+    }
+
+    std::vector<char> data{b.data.begin(), b.data.end()};
+    CHECK_NOTHROW(verify<MapType>(data, 0));
+
+    const auto & map{*reinterpret_cast<const MapType *>(data.data())};
+    auto & item{const_cast<MapType::ItemType &>(*map.find(1))};
+    item.first = 9;
+
+    CHECK_THROWS_AS(verify<MapType>(data, 0), std::invalid_argument);
+}
+
+TEST_CASE("verify cycle")
+{
+    builder b;
+
+    {
+        auto first{b.add<node>()};
+        auto second{b.add<node>()};
+        first->next = second;
+        second->next = first;
+    }
+
+    const std::vector<char> data{b.data.begin(), b.data.end()};
+
+    CHECK_NOTHROW(verify<node>(data, 0));
+    CHECK_NOTHROW(verify<node>(data, 0, 2));
+}
+
+TEST_CASE("open verified blob")
+{
+    builder b;
+
+    {
+        auto header{add_blob_header(b)};
+        auto root{b.add<node>()};
+        root->value = 42;
+        root->next = b.add<node>();
+        finish_blob(header, root);
+    }
+
+    std::vector<char> data{b.data.begin(), b.data.end()};
+    CHECK(open_verified_blob<node>(data).value == 42);
+
+    auto & next{*reinterpret_cast<std::int32_t *>(data.data() + sizeof(blob_header))};
+    next = 1000;
+
+    CHECK_NOTHROW(open_blob<node>(data));
+    CHECK_THROWS_AS(open_verified_blob<node>(data), std::invalid_argument);
+}
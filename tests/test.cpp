@@ -8,13 +8,16 @@
 #include "pid-debug.h"
 
 #include <thread>
+#include <filesystem>
+#include <fstream>
+#include <random>
 
 using namespace pid;
 
 std::vector<char> move_builder_data(builder & b)
 {
     const char * p1{b.data.data()};
-    std::vector<char> result{b.data};
+    std::vector<char> result{b.data.begin(), b.data.end()};
 
     const char * p2{result.data()};
 
@@ -450,6 +453,536 @@ TEST_CASE("map string -> int")
     CHECK(m.find("five") == m.end());
 }
 
+TEST_CASE("prefix strings")
+{
+    struct S
+    {
+        pid::prefix_string empty;
+        pid::prefix_string short_string;
+        pid::prefix_string full_inline;
+        pid::prefix_string long_string;
+        pid8::prefix_string same_prefix;
+        pid64::prefix_string long_string_2;
+    };
+
+    builder b;
+
+    {
+        auto offset{b.add<S>()};
+        offset->empty = b.add_prefix_string("");
+        offset->short_string = b.add_prefix_string("abc");
+        offset->full_inline = b.add_prefix_string("abcdefghijkl");
+        offset->long_string = b.add_prefix_string("abcdefghijklm");
+        offset->same_prefix = b.add_prefix_string("abcdzzzzzzzzzzzz");
+        offset->long_string_2 = b.add_prefix_string("abcdefghijklm");
+    }
+
+    const auto data{move_builder_data(b)};
+    const S & s{as<S>(data)};
+
+    CHECK(sizeof(pid::prefix_string) == 16);
+    CHECK(sizeof(pid8::prefix_string) == 16);
+    CHECK(sizeof(pid64::prefix_string) == 16);
+
+    // Only the long strings are stored behind the handles, with their length and terminator
+    CHECK(data.size() == sizeof(S) + 20 + 24 + 18);
+
+    CHECK(s.empty.empty());
+    CHECK(s.empty == "");
+    CHECK(s.short_string == "abc");
+    CHECK(s.short_string.size() == 3);
+    CHECK(s.full_inline == "abcdefghijkl");
+    CHECK(s.long_string == "abcdefghijklm");
+    CHECK(s.same_prefix == std::string{"abcdzzzzzzzzzzzz"});
+    CHECK(std::string_view{s.long_string_2} == "abcdefghijklm");
+
+    CHECK(s.long_string == s.long_string_2);
+    CHECK(s.long_string_2 == s.long_string);
+    CHECK(s.short_string != s.full_inline);
+    CHECK(s.long_string != "abcdefghijkln");
+
+    CHECK(s.empty < s.short_string);
+    CHECK(s.short_string < s.full_inline);
+    CHECK(s.full_inline < s.long_string);
+    CHECK(s.long_string < s.same_prefix);
+    CHECK(s.same_prefix > s.long_string_2);
+    CHECK(s.long_string < "abcdefghijkln");
+    CHECK("abcdefghijkl" < s.long_string);
+    CHECK(s.short_string > "ab");
+    CHECK(s.short_string < "abd");
+}
+
+TEST_CASE("hashed strings")
+{
+    struct S
+    {
+        pid::hashed_string a1;
+        pid16::hashed_string8 a2;
+        pid::hashed_string b;
+    };
+
+    builder b;
+
+    {
+        auto offset{b.add<S>()};
+        offset->a1 = b.add_hashed_string("a");
+        offset->a2 = b.add_hashed_string<std::uint8_t>("a");
+        offset->b = b.add_hashed_string("b");
+    }
+
+    const auto data{move_builder_data(b)};
+    const S & s{as<S>(data)};
+
+    CHECK(s.a1.hash() == pid::hashed_string::hash_of("a"));
+    CHECK(s.a1.hash() == s.a2.hash());
+    CHECK(s.a1.hash() != s.b.hash());
+
+    CHECK(s.a1 == s.a2);
+    CHECK(s.a2 == s.a1);
+    CHECK(s.a1 != s.b);
+    CHECK(s.a1 == "a");
+    CHECK(s.a1 < "b");
+    CHECK(s.b.size() == 1);
+
+    const std::string_view key{"b"};
+    const auto hash{pid::hashed_string::hash_of(key)};
+    CHECK(s.b.equals(key, hash));
+    CHECK(not s.a1.equals(key, hash));
+}
+
+TEST_CASE("hashed strings are deterministic")
+{
+    builder clean;
+    const auto expected{clean.add_hashed_string("hello world")};
+
+    // Leave non-zero bytes behind the end of the data
+    builder dirty;
+    for (int i{0}; i < 8; ++i) {
+        *dirty.add<std::uint64_t>() = ~std::uint64_t{0};
+    }
+    dirty.data.resize(0);
+    const auto result{dirty.add_hashed_string("hello world")};
+
+    REQUIRE(result.offset == expected.offset);
+    REQUIRE(dirty.data.size() == clean.data.size());
+    for (std::size_t index{0}; index < clean.data.size(); ++index) {
+        CHECK(dirty.data.data()[index] == clean.data.data()[index]);
+    }
+
+    // The bytes behind the null terminator are zero
+    const std::size_t terminator{
+        offsetof(detail::generic_hashed_string_data<std::uint32_t>, data) + 11};
+    for (std::size_t index{terminator}; index < dirty.data.size(); ++index) {
+        CHECK(dirty.data.data()[index] == 0);
+    }
+}
+
+TEST_CASE("compressed string vector")
+{
+    std::vector<std::string> strings;
+    std::size_t characters{0};
+    for (int i{0}; i < 1000; ++i) {
+        strings.push_back(
+            "https://www.example.com/products/" + std::to_string(i % 300) + "/index.html");
+        characters += strings.back().size();
+    }
+    strings.push_back("");
+    strings.push_back("\xff\x01 unusual characters \xfe");
+
+    builder b;
+
+    {
+        auto root{b.add<pid::compressed_string_vector>()};
+        *root = b.add_compressed_string_vector<std::uint32_t>(strings);
+    }
+
+    const auto data{move_builder_data(b)};
+    const auto & v{as<pid::compressed_string_vector>(data)};
+
+    CHECK(data.size() < characters / 2);
+
+    REQUIRE(v.size() == strings.size());
+    for (std::uint32_t i{0}; i < v.size(); ++i) {
+        CHECK(v[i] == strings[i]);
+        CHECK(v.equal(i, strings[i]));
+    }
+    CHECK_THROWS_AS(v.at(v.size()), std::out_of_range);
+    CHECK(v.compressed(1000).empty());
+
+    CHECK(v.equal(1, 301));
+    CHECK(not v.equal(1, 2));
+    CHECK(not v.equal(1, strings[2]));
+    CHECK(not v.equal(1, strings[1] + "x"));
+    CHECK(not v.equal(1, strings[1].substr(0, 10)));
+
+    std::array<char, 100> buffer;
+    CHECK(v.decompress(5, buffer) == strings[5]);
+    CHECK_THROWS_AS(v.decompress(5, std::span{buffer}.first(10)), std::length_error);
+    CHECK(v.decompress(5, std::span{buffer}.first(strings[5].size())) == strings[5]);
+}
+
+TEST_CASE("map prefix_string -> int")
+{
+    using MapType = pid::map<pid::prefix_string, std::int32_t>;
+
+    builder b;
+
+    {
+        auto map{b.add<MapType>()};
+        auto map_builder{b.add_map<pid::prefix_string, std::int32_t, std::uint32_t>(4)};
+        *map = map_builder.items;
+
+        *map_builder.add_key(b.add_prefix_string("a long key number 1")) = 1;
+        *map_builder.add_key(b.add_prefix_string("a long key number 2")) = 2;
+        CHECK_THROWS_AS(
+            map_builder.add_key(b.add_prefix_string("a long key number 2")), std::logic_error);
+        *map_builder.add_key(b.add_prefix_string("short")) = 3;
+        *map_builder.add_key(b.add_prefix_string("very long key")) = 4;
+    }
+
+    const auto data{move_builder_data(b)};
+    const auto & m{as<MapType>(data)};
+
+    REQUIRE(m.size() == 4);
+    CHECK(m.at("a long key number 1") == 1);
+    CHECK(m.at("a long key number 2") == 2);
+    CHECK(m.at("short") == 3);
+    CHECK(m.at(std::string{"very long key"}) == 4);
+    CHECK(m.find("a long key number 3") == m.end());
+    CHECK(m.find("shor") == m.end());
+}
+
+TEST_CASE("unpack bits")
+{
+    std::mt19937_64 random{42};
+
+    std::vector<std::uint64_t> words(100);
+    std::generate(words.begin(), words.end(), random);
+
+    // The vectorized implementation (if available) must agree with the scalar one
+    for (unsigned width{0}; width <= 64; ++width) {
+        const std::size_t count{(words.size() - 1) * 64 / std::max(width, 1u) - 3};
+        std::vector<std::uint64_t> expected(count);
+        std::vector<std::uint64_t> actual(count);
+
+        detail::unpack_bits_scalar(words.data(), 3, width, count, expected.data());
+        detail::unpack_bits(words.data(), 3, width, count, actual.data());
+
+        CHECK(expected == actual);
+    }
+}
+
+TEMPLATE_TEST_CASE(
+    "packed vector", "", std::uint8_t, std::int16_t, std::uint32_t, std::int32_t, std::uint64_t,
+    std::int64_t)
+{
+    std::mt19937_64 random{42};
+
+    // Small random numbers, sorted numbers with large gaps, and values from the full range
+    std::vector<TestType> values;
+    for (std::size_t index{0}; index < 1000; ++index) {
+        values.push_back(static_cast<TestType>(random() % 100));
+    }
+    for (std::size_t index{0}; index < 1000; ++index) {
+        values.push_back(static_cast<TestType>(values.back() + random() % 5));
+    }
+    for (std::size_t index{0}; index < 1000; ++index) {
+        values.push_back(static_cast<TestType>(random()));
+    }
+
+    for (const std::size_t size : {0, 1, 5, 128, 129, 1000, 2000, 3000}) {
+        const std::span<const TestType> input{values.data(), size};
+
+        builder b;
+
+        {
+            auto v{b.add<pid::packed_vector<TestType>>()};
+            *v = b.add_packed_vector<TestType, std::uint32_t>(input);
+        }
+
+        const auto data{move_builder_data(b)};
+        const auto & v{as<pid::packed_vector<TestType>>(data)};
+
+        REQUIRE(v.size() == size);
+        CHECK(v.empty() == (size == 0));
+
+        for (std::size_t index{0}; index < size; ++index) {
+            REQUIRE(v[index] == input[index]);
+        }
+        CHECK_THROWS_AS(v.at(size), std::out_of_range);
+
+        CHECK(std::equal(v.begin(), v.end(), input.begin(), input.end()));
+
+        // Decode ranges which start and end inside and at the borders of blocks
+        for (const std::size_t first : {0, 1, 127, 128, 300}) {
+            for (const std::size_t count : {0, 1, 3, 127, 128, 500}) {
+                if (first + count <= size) {
+                    std::vector<TestType> decoded(count);
+                    v.decode(first, count, decoded.data());
+                    CHECK(std::equal(
+                        decoded.begin(), decoded.end(), input.begin() + first,
+                        input.begin() + first + count));
+                }
+            }
+        }
+        CHECK_THROWS_AS(v.decode(size, 1, nullptr), std::out_of_range);
+
+        // Small and sorted numbers need much fewer bits than the type has
+        if (size <= 1000) {
+            for (std::size_t index{0}; index < size; ++index) {
+                CHECK(v.bit_width(index) <= 7);
+            }
+        }
+    }
+}
+
+TEST_CASE("packed vector with an outlier block")
+{
+    // Sorted timestamps with one large jump in the third block
+    std::vector<std::uint64_t> values;
+    std::uint64_t timestamp{1'700'000'000};
+    for (std::size_t index{0}; index < 1000; ++index) {
+        timestamp += index == 300 ? std::uint64_t{1} << 40 : index % 3;
+        values.push_back(timestamp);
+    }
+
+    builder b;
+
+    {
+        auto v{b.add<pid::packed_vector<std::uint64_t>>()};
+        *v = b.add_packed_vector<std::uint64_t, std::uint32_t>(values);
+    }
+
+    const auto data{move_builder_data(b)};
+    const auto & v{as<pid::packed_vector<std::uint64_t>>(data)};
+
+    REQUIRE(v.size() == values.size());
+    CHECK(std::equal(v.begin(), v.end(), values.begin(), values.end()));
+
+    // Only the block with the jump needs wide values
+    CHECK(v.bit_width(300) == 41);
+    for (const std::size_t index : {0, 255, 384, 999}) {
+        CHECK(v.bit_width(index) <= 8);
+    }
+    CHECK(data.size() < 1000 * 2);
+}
+
+TEMPLATE_TEST_CASE(
+    "map find with integer keys", "", std::int16_t, std::uint16_t, std::int32_t, std::uint32_t,
+    std::int64_t, std::uint64_t)
+{
+    // Every third number around 0, whose negative values wrap around for unsigned types, and
+    // from max / 2 + 1, which only has the highest bit set for unsigned types
+    std::vector<TestType> keys;
+    for (int i{-300}; i < 300; i += 3) {
+        keys.push_back(static_cast<TestType>(i));
+    }
+    for (int i{0}; i < 300; i += 3) {
+        keys.push_back(static_cast<TestType>(std::numeric_limits<TestType>::max() / 2 + 1 + i));
+    }
+    std::sort(keys.begin(), keys.end());
+    keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+
+    // The vectorized comparison (if available) must agree with the scalar one
+    for (const std::size_t stride : {sizeof(TestType), 3 * sizeof(TestType)}) {
+        const auto first{reinterpret_cast<const char *>(keys.data())};
+        const std::size_t count{keys.size() * sizeof(TestType) / stride};
+        for (const TestType key : {keys[0], keys[count / 2], TestType{1}}) {
+            CHECK(detail::count_less(first, stride, count, key)
+                  == detail::count_less_scalar(first, stride, count, key));
+        }
+    }
+
+    for (const std::size_t size : std::initializer_list<std::size_t>{
+             0, 1, 2, 15, 16, 17, 64, 65, 100, keys.size()}) {
+        using MapType = pid::map<TestType, std::int32_t>;
+        using SoaMapType = pid::soa_map<TestType, std::int32_t>;
+
+        builder b;
+
+        {
+            auto root{b.add<std::pair<MapType, SoaMapType>>()};
+            auto map{b.add_map<TestType, std::int32_t, std::uint32_t>(size)};
+            auto soa_map{b.add_soa_map<TestType, std::int32_t, std::uint32_t>(size)};
+            root->first = map.items;
+            root->second = soa_map.offset();
+            for (std::size_t i{0}; i < size; ++i) {
+                *map.add_key(keys[i]) = static_cast<std::int32_t>(i);
+                *soa_map.add_key(keys[i]) = static_cast<std::int32_t>(i);
+            }
+        }
+
+        const auto data{move_builder_data(b)};
+        const auto & [map, soa_map] = as<std::pair<MapType, SoaMapType>>(data);
+
+        for (std::size_t i{0}; i < size; ++i) {
+            REQUIRE(map.at(keys[i]) == static_cast<std::int32_t>(i));
+            REQUIRE(soa_map.at(keys[i]) == static_cast<std::int32_t>(i));
+
+            const auto missing{static_cast<TestType>(keys[i] + 1)};
+            CHECK(map.find(missing) == map.end());
+            CHECK(soa_map.find(missing) == soa_map.end());
+        }
+
+        // Keys of other types, including ones which Key cannot represent
+        CHECK(map.find(-1) == map.end());
+        CHECK(map.find(std::numeric_limits<std::uint64_t>::max()) == map.end());
+        CHECK(soa_map.find(std::numeric_limits<std::int64_t>::min()) == soa_map.end());
+        if (size > 100) {
+            CHECK(map.at(std::int64_t{3}) == soa_map.at(3));
+        }
+    }
+}
+
+TEST_CASE("soa map int -> string")
+{
+    using MapType = pid::soa_map<std::int32_t, pid::string>;
+
+    builder b;
+
+    {
+        auto map{b.add<MapType>()};
+        auto map_builder{b.add_soa_map<std::int32_t, pid::string, std::uint32_t>(3)};
+        *map = map_builder.offset();
+
+        *map_builder.add_key(1) = b.add_string("one");
+
+        // check sorting violations
+        CHECK_THROWS_AS(map_builder.add_key(0), std::logic_error);
+        CHECK_THROWS_AS(map_builder.add_key(1), std::logic_error);
+
+        *map_builder.add_key(2) = b.add_string("two");
+        *map_builder.add_key(4) = b.add_string("four");
+
+        CHECK_THROWS_AS(map_builder.add_key(5), std::out_of_range);
+    }
+
+    const auto data{move_builder_data(b)};
+    const auto & m{as<MapType>(data)};
+
+    REQUIRE(m.size() == 3);
+    CHECK(m.at(1) == "one");
+    CHECK(m.at(2) == "two");
+    CHECK(m.at(4) == "four");
+    CHECK_THROWS_AS(m.at(3), std::out_of_range);
+    CHECK(m.find(1) == m.begin());
+    CHECK((*m.find(4)).second == "four");
+}
+
+TEMPLATE_TEST_CASE("s-tree map", "", std::int16_t, std::int32_t, std::uint64_t)
+{
+    // Trees with one to four layers, with full and partial nodes
+    for (const std::size_t size : std::initializer_list<std::size_t>{
+             0, 1, 15, 16, 17, 16 * 17, 16 * 17 + 1, 5000, 16 * 17 * 17 * 3}) {
+        using MapType = pid::s_tree_map<TestType, std::uint32_t>;
+
+        // Even numbers, starting below 0 for signed types
+        std::vector<TestType> keys;
+        const auto first{static_cast<TestType>(std::is_signed_v<TestType> ? -1000 : 0)};
+        for (std::size_t i{0}; i < size; ++i) {
+            keys.push_back(static_cast<TestType>(first + 2 * static_cast<TestType>(i)));
+        }
+
+        builder b;
+
+        {
+            auto root{b.add<MapType>()};
+            auto map{b.add_s_tree_map<TestType, std::uint32_t, std::uint32_t>(size)};
+            *root = map.offset();
+            for (std::size_t i{0}; i < size; ++i) {
+                *map.add_key(keys[i]) = static_cast<std::uint32_t>(i);
+            }
+
+            if (size > 0) {
+                CHECK_THROWS_AS(map.add_key(keys.back()), std::out_of_range);
+            }
+        }
+
+        const auto data{move_builder_data(b)};
+        const auto & m{as<MapType>(data)};
+
+        REQUIRE(m.size() == size);
+        CHECK(m.empty() == (size == 0));
+        CHECK(std::equal(
+            m.begin(), m.end(), keys.begin(), keys.end(),
+            [](const auto & item, TestType key) { return item.first == key; }));
+
+        for (std::size_t i{0}; i < size; ++i) {
+            REQUIRE(m.at(keys[i]) == i);
+            CHECK(m.find(static_cast<TestType>(keys[i] + 1)) == m.end());
+            CHECK(m.lower_bound(keys[i]) == m.begin() + i);
+            if (i > 0) {
+                CHECK(m.lower_bound(static_cast<TestType>(keys[i] - 1)) == m.begin() + i);
+            }
+            CHECK(m.lower_bound(static_cast<TestType>(keys[i] + 1)) == m.begin() + i + 1);
+            CHECK(m.upper_bound(keys[i]) == m.begin() + i + 1);
+        }
+
+        CHECK(m.lower_bound(std::numeric_limits<std::int64_t>::min()) == m.begin());
+        CHECK(m.lower_bound(std::numeric_limits<std::uint64_t>::max()) == m.end());
+        CHECK(m.find(std::numeric_limits<TestType>::max()) == m.end());
+
+        if (size >= 16) {
+            const auto items{m.range(keys[3], keys[15])};
+            REQUIRE(items.size() == 12);
+            CHECK(items.front().second == 3);
+            CHECK(items.back().second == 14);
+            CHECK(m.range(keys[15], keys[3]).empty());
+        }
+    }
+}
+
+TEST_CASE("hash map string -> int")
+{
+    using MapType = pid::hash_map<pid::string, std::int32_t>;
+
+    builder b;
+
+    {
+        const std::vector<std::string> keys{"one", "two", "three", "four", "six"};
+
+        auto map{b.add<MapType>()};
+        auto map_builder{b.add_hash_map<pid::string, std::int32_t, std::uint32_t>(keys)};
+        *map = map_builder.offset();
+
+        // Keys can be added in any order
+        *map_builder.add_key(b.add_string("two")) = 2;
+        *map_builder.add_key(b.add_string("six")) = 6;
+        *map_builder.add_key(b.add_string("one")) = 1;
+
+        CHECK_THROWS_AS(map_builder.add_key(b.add_string("one")), std::logic_error);
+        CHECK_THROWS_AS(map_builder.add_key(b.add_string("five")), std::invalid_argument);
+
+        *map_builder.add_key(b.add_string("four")) = 4;
+        *map_builder.add_key(b.add_string("three")) = 3;
+    }
+
+    const auto data{move_builder_data(b)};
+    const auto & m{as<MapType>(data)};
+
+    REQUIRE(m.size() == 5);
+
+    CHECK(m.at("one") == 1);
+    CHECK(m.at("two") == 2);
+    CHECK(m.at("three") == 3);
+    CHECK(m.at("four") == 4);
+    CHECK(m.at("six") == 6);
+
+    CHECK_THROWS_AS(m.at("five"), std::out_of_range);
+    CHECK(m.find("five") == m.end());
+    CHECK(m.find("four")->first == "four");
+    CHECK(m.find("four")->second == 4);
+}
+
+TEST_CASE("hash map with duplicate keys")
+{
+    builder b;
+
+    const std::vector<std::int32_t> keys{1, 2, 3, 2};
+    CHECK_THROWS_AS(
+        (b.add_hash_map<std::int32_t, std::int32_t, std::uint32_t>(keys)), std::invalid_argument);
+}
+
 namespace {
     auto alignment(const auto & rel)
     {
@@ -771,3 +1304,328 @@ TEST_CASE("move data from sub builders")
         }
     }
 }
+
+TEST_CASE("builder backed by a memory-mapped file")
+{
+    const auto path{std::filesystem::temp_directory_path() / "pid-test-mapped-builder.bin"};
+
+    constexpr std::uint32_t item_count{100000};
+
+    {
+        builder b{builder_storage::mapped_file(path)};
+        REQUIRE(b.data.is_mapped_file());
+
+        auto offset_v{b.add<pid::vector<pid::string>>()};
+        *offset_v = b.add_vector<pid::string, std::uint32_t>(item_count);
+
+        // Adding the strings grows the mapping many times
+        for (std::uint32_t index{0}; index < item_count; ++index) {
+            const auto s{b.add_string("item " + std::to_string(index))};
+            (*offset_v)[index] = s;
+        }
+
+        REQUIRE(b.data.capacity() >= b.data.size());
+    }
+
+    // The file must have been truncated to the size of the data
+    std::ifstream file{path, std::ios::binary};
+    const std::vector<char> data{
+        std::istreambuf_iterator<char>{file}, std::istreambuf_iterator<char>{}};
+    std::filesystem::remove(path);
+
+    const auto & v{as<pid::vector<pid::string>>(data)};
+
+    REQUIRE(v.size() == item_count);
+    for (std::uint32_t index{0}; index < item_count; ++index) {
+        CHECK(v[index] == "item " + std::to_string(index));
+    }
+    CHECK(data.size() == static_cast<std::size_t>(v.end()[-1].end() + 1 - data.data()));
+}
+
+TEST_CASE("concurrent builder with fixed address space")
+{
+    struct s
+    {
+        pid::vector<pid::string> items;
+    };
+
+    struct parent
+    {
+        pid::vector<pid::ptr<s>> children;
+    };
+
+    constexpr std::size_t children_count{64};
+    constexpr std::uint32_t item_count{1000};
+
+    builder b{builder_storage::address_space(std::size_t{1} << 32)};
+    REQUIRE(b.data.has_fixed_address());
+    const char * const start{b.data.data()};
+
+    {
+        auto offset_parent{b.add<parent>()};
+        offset_parent->children = b.add_vector<pid::ptr<s>, std::uint32_t>(children_count);
+
+        // Half of the threads add their data directly to the parent builder, the others use a
+        // sub builder. No lock is needed in either case.
+        auto build_data = [&](std::size_t child_index) {
+            const auto add_child = [&](builder & target) {
+                auto offset_s{target.add<s>()};
+                offset_s->items = target.add_vector<pid::string, std::uint32_t>(item_count);
+                for (std::uint32_t index{0}; index < item_count; ++index) {
+                    offset_s->items[index] = target.add_string(
+                        "child " + std::to_string(child_index) + ", item "
+                        + std::to_string(index));
+                }
+                return offset_s;
+            };
+
+            if (child_index % 2 == 0) {
+                offset_parent->children[child_index] = add_child(b);
+            } else {
+                builder sub_builder;
+                const auto offset_s{add_child(sub_builder)};
+                offset_parent->children[child_index] = b.add_sub_builder(sub_builder)(offset_s);
+            }
+        };
+
+        std::vector<std::jthread> threads;
+        for (std::size_t child_index{0}; child_index < children_count; ++child_index) {
+            threads.emplace_back(build_data, child_index);
+        }
+    }
+
+    // The data have never been moved
+    CHECK(b.data.data() == start);
+
+    const auto data{move_builder_data(b)};
+    const auto & result{as<parent>(data)};
+
+    REQUIRE(result.children.size() == children_count);
+    for (std::size_t child_index{0}; child_index < children_count; ++child_index) {
+        const auto & child{result.children[child_index]};
+        REQUIRE(child);
+        REQUIRE(child->items.size() == item_count);
+        for (std::uint32_t item_index{0}; item_index < item_count; ++item_index) {
+            CHECK(
+                child->items[item_index]
+                == "child " + std::to_string(child_index) + ", item "
+                       + std::to_string(item_index));
+        }
+    }
+}
+
+TEST_CASE("fixed address space is exhausted")
+{
+    builder b{builder_storage::address_space(64)};
+
+    b.add<std::uint64_t>(56);
+    CHECK(b.data.size() == 64);
+
+    CHECK_THROWS_AS(b.add<char>(), std::length_error);
+    CHECK_THROWS_AS(b.data.reserve(128), std::length_error);
+
+    // Bytes which are released and added again are zero
+    b.data.data()[8] = 1;
+    b.data.resize(8);
+    CHECK(*b.add<char>() == 0);
+}
+
+TEST_CASE("builder streaming to a file")
+{
+    const auto path{std::filesystem::temp_directory_path() / "pid-test-streamed-builder.bin"};
+
+    constexpr std::uint32_t item_count{100000};
+    constexpr std::size_t window_size{1 << 16};
+    std::size_t root_offset;
+
+    {
+        builder b{builder_storage::streamed_file(path, window_size)};
+        REQUIRE(b.data.is_streamed_file());
+
+        auto early{b.add<pid::ptr<std::int32_t>>()};
+
+        // The strings are final as soon as they have been added
+        using string_offset = decltype(b.add_string(""));
+        std::vector<std::size_t> offsets;
+        for (std::uint32_t index{0}; index < item_count; ++index) {
+            offsets.push_back(b.add_string("item " + std::to_string(index)).offset);
+            if (index % 1000 == 0) {
+                b.data.flush(b.data.size());
+            }
+        }
+
+        CHECK(b.data.flushed_size() > 0);
+        CHECK(b.data.flushed_size() % builder_storage::flush_alignment == 0);
+        CHECK(b.data.capacity() == window_size);
+
+        // Pointers may point to flushed data, but cannot be stored in them
+        CHECK_THROWS_AS(*early = b.add<std::int32_t>(), std::logic_error);
+        CHECK_THROWS_AS(early->offset, std::logic_error);
+        CHECK_THROWS_AS(b.data.resize(0), std::logic_error);
+
+        auto offset_v{b.add<pid::vector<pid::string>>()};
+        root_offset = offset_v.offset;
+        *offset_v = b.add_vector<pid::string, std::uint32_t>(item_count);
+        for (std::uint32_t index{0}; index < item_count; ++index) {
+            (*offset_v)[index] = string_offset{b, offsets[index]};
+        }
+
+        CHECK(b.data.capacity() < b.data.size());
+    }
+
+    std::ifstream file{path, std::ios::binary};
+    const std::vector<char> data{
+        std::istreambuf_iterator<char>{file}, std::istreambuf_iterator<char>{}};
+    std::filesystem::remove(path);
+
+    const auto & v{*reinterpret_cast<const pid::vector<pid::string> *>(data.data() + root_offset)};
+
+    REQUIRE(v.size() == item_count);
+    for (std::uint32_t index{0}; index < item_count; ++index) {
+        CHECK(v[index] == "item " + std::to_string(index));
+    }
+}
+
+TEST_CASE("add uninitialized vector")
+{
+    builder b;
+
+    // Leave non-zero bytes behind the end of the data
+    *b.add<std::uint64_t>() = ~std::uint64_t{0};
+    b.data.resize(1);
+
+    auto v{b.add_vector_uninitialized<std::int64_t, std::uint32_t>(3)};
+    REQUIRE(v.offset == sizeof(std::int64_t));
+
+    // The padding in front of the vector and behind its length is zeroed
+    for (std::size_t index{1}; index < b.data.size(); ++index) {
+        if (index < v.offset or (index >= v.offset + 4 and index < v.offset + 8)) {
+            CHECK(b.data.data()[index] == 0);
+        }
+    }
+
+    for (std::uint32_t index{0}; index < 3; ++index) {
+        (*v)[index] = -static_cast<std::int64_t>(index);
+    }
+
+    CHECK(v->size() == 3);
+    CHECK((*v)[2] == -2);
+    CHECK(b.data.size() == 5 * sizeof(std::int64_t));
+}
+
+TEST_CASE("add uninitialized object with a flexible array member in its tail padding")
+{
+    using DataType = detail::generic_hashed_string_data<std::uint32_t>;
+    static_assert(offsetof(DataType, data) < sizeof(DataType));
+
+    builder b;
+
+    // Leave non-zero bytes behind the end of the data
+    for (int i{0}; i < 8; ++i) {
+        *b.add<std::uint64_t>() = ~std::uint64_t{0};
+    }
+    b.data.resize(0);
+
+    // The caller writes the items of the member, which end before the allocation does
+    constexpr std::size_t item_count{5};
+    auto object{b.add_uninitialized<DataType>(item_count)};
+    std::memset(object->data, 'x', item_count);
+
+    REQUIRE(b.data.size() == sizeof(DataType) + item_count);
+    for (std::size_t index{offsetof(DataType, data) + item_count}; index < b.data.size();
+         ++index) {
+        CHECK(b.data.data()[index] == 0);
+    }
+}
+
+TEST_CASE("merging sub builders zeroes the alignment gaps")
+{
+    builder first;
+    *first.add<std::uint8_t>() = 1;
+    builder second;
+    *second.add<std::uint8_t>() = 2;
+
+    // Leave non-zero bytes behind the end of the data
+    builder b;
+    for (int i{0}; i < 8; ++i) {
+        *b.add<std::uint64_t>() = ~std::uint64_t{0};
+    }
+    b.data.resize(0);
+
+    const std::vector<const builder *> others{&first, &second};
+    const auto movers{b.add_sub_builders(others, 2)};
+
+    REQUIRE(b.data.size() == 2 * sizeof(std::uint64_t));
+    for (std::size_t index{0}; index < b.data.size(); ++index) {
+        const char expected{index == 0 ? char{1} : index == 8 ? char{2} : char{0}};
+        CHECK(b.data.data()[index] == expected);
+    }
+}
+
+TEST_CASE("merge sub builders in parallel")
+{
+    constexpr std::size_t builder_count{16};
+    constexpr std::uint32_t item_count{20000};
+
+    std::vector<std::unique_ptr<builder>> sub_builders;
+    std::vector<std::optional<builder_offset<pid::vector<pid::string>>>> roots(builder_count);
+    for (std::size_t builder_index{0}; builder_index < builder_count; ++builder_index) {
+        sub_builders.push_back(std::make_unique<builder>());
+    }
+
+    {
+        std::vector<std::jthread> threads;
+        for (std::size_t builder_index{0}; builder_index < builder_count; ++builder_index) {
+            threads.emplace_back([&, builder_index] {
+                builder & sub_builder{*sub_builders[builder_index]};
+                auto root{sub_builder.add<pid::vector<pid::string>>()};
+
+                // The sub builders have different sizes, and some are empty
+                const std::uint32_t count{builder_index % 4 == 0 ? 0 : item_count};
+                *root = sub_builder.add_vector<pid::string, std::uint32_t>(count);
+                for (std::uint32_t index{0}; index < count; ++index) {
+                    (*root)[index] = sub_builder.add_string(
+                        std::to_string(builder_index) + "/" + std::to_string(index));
+                }
+                roots[builder_index].emplace(root);
+            });
+        }
+    }
+
+    struct parent
+    {
+        pid::vector<pid::ptr<pid::vector<pid::string>>> children;
+    };
+
+    builder b;
+
+    {
+        auto offset_parent{b.add<parent>()};
+        offset_parent->children =
+            b.add_vector<pid::ptr<pid::vector<pid::string>>, std::uint32_t>(builder_count);
+
+        std::vector<const builder *> others;
+        for (const auto & sub_builder : sub_builders) {
+            others.push_back(sub_builder.get());
+        }
+
+        const auto movers{b.add_sub_builders(others, 4)};
+        REQUIRE(movers.size() == builder_count);
+
+        for (std::size_t builder_index{0}; builder_index < builder_count; ++builder_index) {
+            offset_parent->children[builder_index] = movers[builder_index](*roots[builder_index]);
+        }
+    }
+
+    const auto data{move_builder_data(b)};
+    const auto & result{as<parent>(data)};
+
+    REQUIRE(result.children.size() == builder_count);
+    for (std::size_t builder_index{0}; builder_index < builder_count; ++builder_index) {
+        const auto & child{*result.children[builder_index]};
+        REQUIRE(child.size() == (builder_index % 4 == 0 ? 0 : item_count));
+        for (std::uint32_t index{0}; index < child.size(); ++index) {
+            CHECK(child[index] == std::to_string(builder_index) + "/" + std::to_string(index));
+        }
+    }
+}